@@ -0,0 +1,103 @@
+/**
+ * @file child_list.cpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief Measures building, indexing, looking up and thinning out a node with 100k children, outside of any engine.
+ * @version 0.1
+ * @date 2024-12-18
+ * @copyright Copyright (c) 2024
+ */
+
+#include <random>
+
+#include <objects.hpp>
+
+typedef std::chrono::duration<double, std::milli> millis;
+
+int main(int argc, char **argv)
+{
+    size_t child_count = argc > 1 ? std::stoul(argv[1]) : 100000;
+    std::mt19937 rng(42);
+
+    auto parent = make_shared<Object>("Parent");
+    vector<shared_ptr<Object>> children;
+    children.reserve(child_count);
+    for (size_t i = 0; i < child_count; i++)
+        children.push_back(make_shared<Object>(i % 2 ? "Enemy" : "Enemy_" + std::to_string(i))); // colliding names too
+
+    auto begin = std::chrono::steady_clock::now();
+    for (auto &child : children)
+        parent->add(child);
+    millis build_time = std::chrono::steady_clock::now() - begin;
+
+    begin = std::chrono::steady_clock::now();
+    size_t sink = 0;
+    for (size_t i = 0; i < child_count; i++)
+        sink += (size_t)parent->getChild(rng() % child_count).get();
+    millis index_time = std::chrono::steady_clock::now() - begin;
+
+    begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < child_count; i++)
+        sink += (size_t)parent->getChild(children[rng() % child_count]->getName()).get();
+    millis name_time = std::chrono::steady_clock::now() - begin;
+
+    begin = std::chrono::steady_clock::now();
+    for (auto &child : children)
+        parent->add(child); // already children, rejected
+    millis duplicate_time = std::chrono::steady_clock::now() - begin;
+
+    begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < child_count; i += 2)
+        parent->removeChild(children[i]->getName());
+    millis remove_time = std::chrono::steady_clock::now() - begin;
+    size_t remaining = child_count / 2;
+
+    begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < remaining; i++)
+        sink += (size_t)parent->getChild(rng() % remaining).get(); // through the tree of live entries
+    millis reindex_time = std::chrono::steady_clock::now() - begin;
+
+    // the same names again, as when respawning: every name is interned already
+    auto second_parent = make_shared<Object>("Parent");
+    begin = std::chrono::steady_clock::now();
+    for (auto &child : children)
+        second_parent->add(child);
+    millis rebuild_time = std::chrono::steady_clock::now() - begin;
+
+    // despawn and respawn under a colliding name, the freed suffix and its interned name are reused
+    begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < child_count; i++)
+    {
+        auto child = second_parent->removeChild(children[1]->getName());
+        second_parent->add(child);
+    }
+    millis churn_time = std::chrono::steady_clock::now() - begin;
+
+    // removals and index lookups taking turns, from the front and then from anywhere
+    begin = std::chrono::steady_clock::now();
+    size_t left = child_count;
+    for (size_t i = 0; i < child_count / 4; i++, left--)
+    {
+        second_parent->removeChild(0);
+        sink += (size_t)second_parent->getChild(0).get();
+    }
+    for (size_t i = 0; i < child_count / 4; i++, left--)
+    {
+        second_parent->removeChild(rng() % left);
+        sink += (size_t)second_parent->getChild(rng() % (left - 1)).get();
+    }
+    millis interleaved_time = std::chrono::steady_clock::now() - begin;
+
+    std::cout << "children: " << child_count << "\n";
+    std::cout << "build: " << build_time.count() * 1e6 / child_count << " ns/child\n";
+    std::cout << "index: " << index_time.count() * 1e6 / child_count << " ns/lookup\n";
+    std::cout << "name: " << name_time.count() * 1e6 / child_count << " ns/lookup\n";
+    std::cout << "duplicate add: " << duplicate_time.count() * 1e6 / child_count << " ns/child\n";
+    std::cout << "remove every other by name: " << remove_time.count() * 1e6 / (child_count - remaining) << " ns/child\n";
+    std::cout << "index after removal: " << reindex_time.count() * 1e6 / remaining << " ns/lookup\n";
+    std::cout << "rebuild, names interned: " << rebuild_time.count() * 1e6 / child_count << " ns/child\n";
+    std::cout << "remove and add again: " << churn_time.count() * 1e6 / child_count << " ns/child\n";
+    std::cout << "remove by index and index, interleaved: " << interleaved_time.count() * 1e6 / (child_count / 2) << " ns/pair\n";
+    if (sink == 1)
+        std::cout << ""; // keeps the lookups from being optimized out
+    return 0;
+}
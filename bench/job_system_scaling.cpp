@@ -0,0 +1,65 @@
+/**
+ * @file job_system_scaling.cpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief Measures how a parallel agent update scales with the number of job system threads.
+ * @version 0.1
+ * @date 2024-12-18
+ * @copyright Copyright (c) 2024
+ */
+
+#include <job_system.hpp>
+#include <vects.hpp>
+
+struct Agent
+{
+    Vect2f position;
+    Vect2f velocity;
+};
+
+// a few dozen flops per agent, roughly a steering behaviour
+static void stepAgent(Agent &agent, Vect2f target, float delta)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        Vect2f desired = target - agent.position;
+        float length = std::sqrt(desired.lengthSquared()) + 0.001f;
+        agent.velocity += (desired / length * 100.0f - agent.velocity) * (delta * 0.5f);
+        agent.position += agent.velocity * (delta / 8);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t agent_count = argc > 1 ? std::stoul(argv[1]) : 100000;
+    int ticks = argc > 2 ? std::stoi(argv[2]) : 200;
+    int max_threads = std::thread::hardware_concurrency();
+    if (max_threads < 1)
+        max_threads = 1;
+
+    std::cout << "agents: " << agent_count << ", ticks: " << ticks << '\n';
+    std::cout << "threads\tms/tick\tspeedup\n";
+    double baseline = 0;
+    for (int threads = 1; threads <= max_threads; threads++)
+    {
+        vector<Agent> agents(agent_count);
+        for (size_t i = 0; i < agent_count; i++)
+            agents[i].position = {(float)(i % 1000), (float)(i / 1000)};
+        JobSystem jobs(threads - 1); // the calling thread is the last one
+
+        auto begin = std::chrono::steady_clock::now();
+        for (int tick = 0; tick < ticks; tick++)
+        {
+            Vect2f target = {(float)tick, 500};
+            jobs.parallelFor(0, agents.size(), 256, [&](size_t i)
+            {
+                stepAgent(agents[i], target, 1.0f / 60);
+            });
+        }
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - begin;
+        double per_tick = elapsed.count() / ticks;
+        if (threads == 1)
+            baseline = per_tick;
+        std::cout << threads << '\t' << per_tick << '\t' << baseline / per_tick << '\n';
+    }
+    return 0;
+}
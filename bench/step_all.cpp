@@ -0,0 +1,61 @@
+/**
+ * @file step_all.cpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief Steps many headless engines sharing one pool, with timers set from serial behaviours, the time limit's
+ * included, and thread safe objects looping in parallel, as a batch of simulations would.
+ * @version 0.1
+ * @date 2024-12-18
+ * @copyright Copyright (c) 2024
+ */
+
+#include <engine.hpp>
+#include <job_system.hpp>
+
+int main(int argc, char **argv)
+{
+    size_t engine_count = argc > 1 ? std::stoul(argv[1]) : 16;
+    size_t object_count = argc > 2 ? std::stoul(argv[2]) : 1000;
+    double time_limit = argc > 3 ? std::stod(argv[3]) : 10;
+
+    Engine::enable(true);
+    auto pool = make_shared<JobSystem>();
+    EngineConfig config;
+    config.headless = true;
+    config.job_system = pool;
+    config.time_limit = time_limit; // scheduled by the engine controller's init on a pool worker, step() runs past it
+    std::atomic<long> fired(0), looped(0);
+    {
+        vector<shared_ptr<Engine>> engines;
+        for (size_t e = 0; e < engine_count; e++)
+        {
+            auto engine = make_shared<Engine>(config);
+            auto spawner = make_shared<Object>("Spawner");
+            spawner->attachInitBehaviour([&fired](Object *obj)
+            {
+                obj->every(0.5, [&fired]() { fired++; });
+            });
+            engine->add(spawner);
+            for (size_t i = 0; i < object_count; i++)
+            {
+                auto obj = make_shared<Object2D>("Agent");
+                obj->setThreadSafe(true);
+                obj->attachLoopBehaviour([&looped](Object *, double) { looped++; });
+                spawner->add(obj);
+            }
+            engines.push_back(engine);
+        }
+
+        unsigned long ticks = (unsigned long)(time_limit * config.tick_rate) * 2;
+        double rate = Engine::stepAll(engines, ticks, *pool);
+        unsigned long stopped = 0;
+        for (auto &engine : engines)
+            stopped += engine->getTickCount() < ticks;
+
+        std::cout << "engines: " << engine_count << ", objects each: " << object_count << "\n";
+        std::cout << "ticks per second, all engines: " << rate << "\n";
+        std::cout << "stopped early: " << stopped << " of " << engine_count << " (should be none)\n";
+        std::cout << "(" << fired << " timer calls, " << looped << " loop calls)\n";
+    }
+    Engine::disable();
+    return 0;
+}
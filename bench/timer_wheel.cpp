@@ -0,0 +1,63 @@
+/**
+ * @file timer_wheel.cpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief Measures scheduling, advancing and cancelling with a million pending timers.
+ * @version 0.1
+ * @date 2024-12-18
+ * @copyright Copyright (c) 2024
+ */
+
+#include <random>
+
+#include <timer_wheel.hpp>
+
+typedef std::chrono::duration<double, std::milli> millis;
+
+int main(int argc, char **argv)
+{
+    size_t timer_count = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    double horizon = argc > 2 ? std::stod(argv[2]) : 600; // delays are spread over this many seconds
+    int ticks = argc > 3 ? std::stoi(argv[3]) : 600;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> delay(0, horizon);
+
+    TimerWheel wheel;
+    unsigned long fired = 0;
+    vector<TimerId> ids;
+    ids.reserve(timer_count);
+
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < timer_count; i++)
+        ids.push_back(wheel.schedule(delay(rng), [&fired]() { fired++; }));
+    millis schedule_time = std::chrono::steady_clock::now() - begin;
+
+    // a tenth of the timers repeat, like periodic behaviours
+    for (size_t i = 0; i < timer_count / 10; i++)
+        wheel.repeat(1 + delay(rng) / horizon, [&fired]() { fired++; });
+
+    begin = std::chrono::steady_clock::now();
+    millis worst(0);
+    for (int tick = 0; tick < ticks; tick++)
+    {
+        auto tick_begin = std::chrono::steady_clock::now();
+        wheel.advance(1.0 / 60);
+        millis tick_time = std::chrono::steady_clock::now() - tick_begin;
+        worst = std::max(worst, tick_time);
+    }
+    millis advance_time = std::chrono::steady_clock::now() - begin;
+
+    begin = std::chrono::steady_clock::now();
+    size_t cancelled = 0;
+    for (size_t i = 0; i < ids.size(); i += 2)
+        cancelled += wheel.cancel(ids[i]);
+    millis cancel_time = std::chrono::steady_clock::now() - begin;
+
+    std::cout << "timers: " << timer_count << " once + " << timer_count / 10 << " repeating, over " << horizon << " s\n";
+    std::cout << "schedule: " << schedule_time.count() * 1e6 / timer_count << " ns/timer\n";
+    std::cout << "advance: " << advance_time.count() / ticks << " ms/tick avg, " << worst.count() << " ms worst, "
+              << fired << " fired in " << ticks << " ticks\n";
+    std::cout << "cancel: " << cancel_time.count() * 1e6 / std::max<size_t>(cancelled, 1) << " ns/timer, "
+              << cancelled << " cancelled\n";
+    std::cout << "pending: " << wheel.pending() << '\n';
+    return 0;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file transform_hierarchy.cpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief Cost of reading world transforms in deep hierarchies, cached against recursing to the root on every read,
+ * and of the engine's pass propagating all transforms.
+ * @version 0.1
+ * @date 2024-12-18
+ * @copyright Copyright (c) 2024
+ */
+
+#include <engine.hpp>
+
+namespace
+{
+    // world position as Object2D computed it before transforms were cached
+    Vect2f recursivePosition(Object2D *obj);
+
+    Vect2f recursiveOrientation(Object2D *obj)
+    {
+        auto parent = dynamic_pointer_cast<Object2D>(obj->getParent());
+        if (parent.get() == nullptr)
+            return obj->getRotation();
+        Vect2f parent_orientation = recursiveOrientation(parent.get());
+        Vect2f rotation = obj->getRotation();
+        return Vect2f(
+            rotation.x * parent_orientation.x - rotation.y * parent_orientation.y,
+            rotation.x * parent_orientation.y + rotation.y * parent_orientation.x);
+    }
+
+    Vect2f recursivePosition(Object2D *obj)
+    {
+        auto parent = dynamic_pointer_cast<Object2D>(obj->getParent());
+        if (parent.get() == nullptr)
+            return obj->getOffset();
+        Vect2f parent_orientation = recursiveOrientation(parent.get());
+        Vect2f offset = obj->getOffset();
+        return recursivePosition(parent.get()) +
+            Vect2f(
+                offset.x * parent_orientation.x - offset.y * parent_orientation.y,
+                offset.x * parent_orientation.y + offset.y * parent_orientation.x);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t leaf_count = argc > 1 ? std::stoul(argv[1]) : 1000;
+    int frames = argc > 2 ? std::stoi(argv[2]) : 20;
+
+    std::cout << "leaves under the deepest node: " << leaf_count << ", ns per leaf read\n";
+    std::cout << "depth\tcached\tcached, root moved each frame\trecursive\n";
+    for (int depth : {1, 8, 32, 128})
+    {
+        auto root = make_shared<Object2D>(Vect2f(0, 0), Vect2f(1, 1));
+        shared_ptr<Object2D> deepest = root;
+        for (int i = 1; i < depth; i++)
+        {
+            auto node = make_shared<Object2D>(Vect2f(1, 0), Vect2f(1, 1));
+            node->setRotation({0.99995f, 0.01f});
+            deepest->add(node);
+            deepest = node;
+        }
+        vector<shared_ptr<Object2D>> leaves;
+        for (size_t i = 0; i < leaf_count; i++)
+        {
+            leaves.push_back(make_shared<Object2D>(Vect2f(i, 0), Vect2f(16, 16)));
+            deepest->add(leaves.back());
+        }
+
+        // reads as Sprite::draw does them, a position and a size
+        float sink = 0;
+        auto read = [&](bool move_root, Vect2f (*position)(Object2D *))
+        {
+            auto begin = std::chrono::steady_clock::now();
+            for (int frame = 0; frame < frames; frame++)
+            {
+                if (move_root)
+                    root->setOffset({(float)frame, 0});
+                for (auto &leaf : leaves)
+                    sink += position(leaf.get()).x + leaf->getSize().x;
+            }
+            std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - begin;
+            return elapsed.count() / frames / leaf_count;
+        };
+        auto cached = [](Object2D *obj) { return obj->getPosition(); };
+        double still = read(false, cached);
+        double moving = read(true, cached);
+        double recursive = read(false, recursivePosition);
+        std::cout << depth << '\t' << still << '\t' << moving << '\t' << recursive << '\n';
+        if (sink == 0.5f)
+            std::cout << ""; // keeps the reads from being optimized out
+    }
+
+    // the engine's pass over all transforms, on a random tree
+    size_t node_count = leaf_count * 100;
+    std::mt19937 rng(1);
+    TransformSystem system;
+    vector<shared_ptr<Object2D>> nodes;
+    for (size_t i = 0; i < node_count; i++)
+    {
+        nodes.push_back(make_shared<Object2D>(Vect2f(1, 0), Vect2f(1, 1)));
+        if (i > 0)
+            nodes[rng() % i]->add(nodes.back());
+        system.add(nodes.back().get());
+    }
+    auto begin = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++)
+        system.update();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - begin;
+    std::cout << "TransformSystem::update over " << node_count << " nodes: " << elapsed.count() / frames / node_count << " ns per node\n";
+    return 0;
+}
@@ -0,0 +1,54 @@
+/**
+ * @file update_list.cpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief Per tick cost of Engine::update with many registered objects, against iterating the old hash set of all objects.
+ * @version 0.1
+ * @date 2024-12-18
+ * @copyright Copyright (c) 2024
+ */
+
+#include <engine.hpp>
+#include <job_system.hpp>
+
+int main(int argc, char **argv)
+{
+    size_t object_count = argc > 1 ? std::stoul(argv[1]) : 100000;
+    size_t active_every = argc > 2 ? std::stoul(argv[2]) : 100; // one object in this many has a loop behaviour
+    int ticks = argc > 3 ? std::stoi(argv[3]) : 1000;
+
+    Engine::enable(true);
+    EngineConfig config;
+    config.headless = true;
+    config.worker_threads = 0;
+    {
+        auto engine = make_shared<Engine>(config);
+        unordered_set<shared_ptr<Object>> legacy_bucket;
+        long counter = 0;
+        for (size_t i = 0; i < object_count; i++)
+        {
+            auto obj = make_shared<Object2D>("Object2D_" + std::to_string(i));
+            if (i % active_every == 0)
+                obj->attachLoopBehaviour([&counter](Object *, double) { counter++; });
+            engine->add(obj);
+            legacy_bucket.insert(obj);
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        for (int tick = 0; tick < ticks; tick++)
+            engine->update(1.0 / 60);
+        std::chrono::duration<double, std::micro> dense = std::chrono::steady_clock::now() - begin;
+
+        begin = std::chrono::steady_clock::now();
+        for (int tick = 0; tick < ticks; tick++)
+            for (auto &obj : legacy_bucket)
+                obj->loop(1.0 / 60);
+        std::chrono::duration<double, std::micro> legacy = std::chrono::steady_clock::now() - begin;
+
+        std::cout << "registered objects: " << object_count << ", looped: " << (object_count + active_every - 1) / active_every << '\n';
+        std::cout << "dense loop list:   " << dense.count() / ticks << " us/tick\n";
+        std::cout << "hash set of all:   " << legacy.count() / ticks << " us/tick\n";
+        std::cout << "(" << counter << " loop calls)\n";
+    }
+    Engine::disable();
+    return 0;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file atom.hpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief Interned strings, compared and hashed by identity.
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include "std_includes.hpp"
+#include <string_view>
+#include <optional>
+
+// defined here
+class Atom;
+
+/**
+ * @brief A string stored once for the whole program. Atoms made from equal strings are the same atom, so comparing
+ * and hashing them costs as much as comparing and hashing a pointer. Interning takes a lock and a hash lookup, reading
+ * the string does not. Interned strings are never freed.
+ */
+class Atom
+{
+    const string *text = nullptr; ///< null for the empty string
+
+public:
+    /**
+     * @brief The empty string.
+     */
+    Atom() = default;
+
+    /**
+     * @brief Intern a string. Only allocates the first time the string is interned.
+     * @param text
+     */
+    Atom(std::string_view text);
+
+    Atom(const string &text) : Atom(std::string_view(text))
+    {
+    }
+
+    Atom(const char *text) : Atom(std::string_view(text))
+    {
+    }
+
+    /**
+     * @brief The atom of a string if it was interned already, without interning it otherwise.
+     * @param text
+     * @return std::optional<Atom>
+     */
+    static std::optional<Atom> find(std::string_view text);
+
+    const string &str() const
+    {
+        static const string empty;
+        return text != nullptr ? *text : empty;
+    }
+
+    bool empty() const
+    {
+        return text == nullptr;
+    }
+
+    bool operator==(const Atom &other) const
+    {
+        return text == other.text;
+    }
+
+    bool operator!=(const Atom &other) const
+    {
+        return text != other.text;
+    }
+
+    size_t hash() const
+    {
+        return std::hash<const string *>()(text);
+    }
+};
+
+template <>
+struct std::hash<Atom>
+{
+    size_t operator()(const Atom &atom) const
+    {
+        return atom.hash();
+    }
+};
@@ -0,0 +1,130 @@
+/**
+ * @file child_list.hpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief Ordered child storage of an Object.
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include "std_includes.hpp"
+
+// defined here
+class ChildList;
+
+// extern
+class Object;
+
+/**
+ * @brief Children of an object in insertion order, in a vector whose removed entries are left empty until they make
+ * up most of it. Each child knows its entry, so finding and removing a child are O(1). Indexing is O(1) as long as
+ * children were only removed from the front, and O(log n) through a tree of live entry counts once some were removed
+ * from the middle. Removing children while iterating is safe, the iteration goes on with the next child still there.
+ * Appending after many removals compacts the vector and should not be mixed with iterating.
+ */
+class ChildList
+{
+    vector<shared_ptr<Object>> entries; ///< null for removed children
+    size_t removed = 0;
+    size_t head = 0; ///< entries before this one are all removed
+    vector<uint32_t> live; ///< Fenwick tree of live entries, empty until indexing needs it
+    uint32_t top_bit = 0; ///< highest power of two within live.size(), where searching the tree starts
+
+    /**
+     * @brief Drop the removed entries, keeping the order of the others, and tell the children their new entries.
+     */
+    void compact();
+
+    /**
+     * @brief Build the tree of live entries from scratch.
+     */
+    void count();
+
+public:
+    class iterator
+    {
+        const vector<shared_ptr<Object>> *entries;
+        size_t index;
+
+        void skip()
+        {
+            while (index < entries->size() && (*entries)[index] == nullptr)
+                index++;
+        }
+
+    public:
+        iterator(const vector<shared_ptr<Object>> *entries, size_t index) : entries(entries), index(index)
+        {
+            skip();
+        }
+
+        const shared_ptr<Object> &operator*() const
+        {
+            return (*entries)[index];
+        }
+
+        iterator &operator++()
+        {
+            index++;
+            skip();
+            return *this;
+        }
+
+        /**
+         * @brief Only meant for comparing against end(), which is reached once no entry is left.
+         */
+        bool operator!=(const iterator &other) const
+        {
+            return (index < entries->size()) != (other.index < other.entries->size());
+        }
+    };
+
+    iterator begin() const
+    {
+        return iterator(&entries, 0);
+    }
+
+    iterator end() const
+    {
+        return iterator(&entries, SIZE_MAX);
+    }
+
+    size_t size() const
+    {
+        return entries.size() - removed;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    /**
+     * @brief Whether the object is one of the children, O(1).
+     * @param child
+     */
+    bool contains(const Object *child) const;
+
+    /**
+     * @brief Append a child. It must not be in any other ChildList.
+     * @param child
+     */
+    void push_back(shared_ptr<Object> child);
+
+    /**
+     * @brief Remove a child, leaving its entry empty.
+     * @param child
+     * @return false if it was not a child
+     */
+    bool erase(const Object *child);
+
+    /**
+     * @brief Child at an index, counting only children still there.
+     * @param index
+     * @throws std::out_of_range if the index is out of range
+     */
+    const shared_ptr<Object> &at(size_t index);
+};
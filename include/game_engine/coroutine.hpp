@@ -0,0 +1,226 @@
+/**
+ * @file coroutine.hpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief Coroutine behaviours, which co_await time, the next tick or an event instead of polling every tick.
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include <coroutine>
+#include <exception>
+
+#include "std_includes.hpp"
+
+// defined here
+class FramePool;
+class Behaviour;
+class BehaviourList;
+struct DelayAwaiter;
+struct NextTickAwaiter;
+struct EventAwaiterBase;
+template <typename EventType>
+struct EventAwaiter;
+
+// extern
+class Object;
+class Event;
+
+/**
+ * @brief Per thread free lists of coroutine frames, in size classes of 64 bytes.
+ * Frames of behaviours which start and finish often are reused instead of going through the heap.
+ */
+class FramePool
+{
+public:
+    static void *allocate(size_t size);
+
+    static void deallocate(void *frame, size_t size);
+};
+
+/**
+ * @brief A coroutine attached to an Object, see Object::attachBehaviour.
+ * Suspended until the engine starts it, and resumed only by the engine, once what it awaits happens:
+ * co_await delay(seconds), co_await nextTick() or auto event = co_await nextEvent<KeyboardEvent>().
+ * Destroyed, wherever it is suspended, when its object is unregistered or destroyed.
+ */
+class Behaviour
+{
+public:
+    struct promise_type
+    {
+        Object *owner = nullptr;
+        shared_ptr<void> alive = make_shared<char>(); ///< pending waits are dropped once the coroutine is gone
+        std::exception_ptr exception;
+
+        static void *operator new(size_t size)
+        {
+            return FramePool::allocate(size);
+        }
+
+        static void operator delete(void *frame, size_t size)
+        {
+            FramePool::deallocate(frame, size);
+        }
+
+        Behaviour get_return_object()
+        {
+            return Behaviour(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_always final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void() {}
+
+        void unhandled_exception()
+        {
+            exception = std::current_exception();
+        }
+    };
+    typedef std::coroutine_handle<promise_type> Handle;
+
+private:
+    Handle handle;
+
+public:
+    explicit Behaviour(Handle handle) : handle(handle) {}
+
+    Behaviour(Behaviour &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+    Behaviour &operator=(Behaviour &&other) noexcept;
+
+    Behaviour(const Behaviour &) = delete;
+    Behaviour &operator=(const Behaviour &) = delete;
+
+    ~Behaviour();
+
+    /**
+     * @brief Run the coroutine up to its first co_await.
+     * @param owner object the behaviour belongs to
+     */
+    void start(Object *owner);
+
+    bool done()
+    {
+        return !handle || handle.done();
+    }
+
+    /**
+     * @brief Continue a suspended coroutine, rethrowing anything it threw.
+     */
+    static void resume(Handle handle);
+};
+
+/**
+ * @brief Running behaviours of an object. Copying an object does not copy its running behaviours, the copy starts its own once registered.
+ */
+class BehaviourList : public list<Behaviour>
+{
+public:
+    BehaviourList() = default;
+
+    BehaviourList(const BehaviourList &) : list<Behaviour>() {}
+
+    BehaviourList &operator=(const BehaviourList &)
+    {
+        return *this;
+    }
+};
+
+/**
+ * @brief Resumes after the given simulated time, through the engine's timer wheel.
+ */
+struct DelayAwaiter
+{
+    double seconds;
+
+    bool await_ready()
+    {
+        return false;
+    }
+
+    void await_suspend(Behaviour::Handle handle);
+
+    void await_resume() {}
+};
+
+/**
+ * @brief Resumes at the start of the next tick.
+ */
+struct NextTickAwaiter
+{
+    bool await_ready()
+    {
+        return false;
+    }
+
+    void await_suspend(Behaviour::Handle handle);
+
+    void await_resume() {}
+};
+
+/**
+ * @brief Resumes once the dispatcher dispatches an event of the given type, which is passed back.
+ */
+struct EventAwaiterBase
+{
+    shared_ptr<Event> event;
+
+    bool await_ready()
+    {
+        return false;
+    }
+
+    void suspend(Behaviour::Handle handle, size_t event_type);
+};
+
+template <typename EventType>
+struct EventAwaiter : EventAwaiterBase
+{
+    void await_suspend(Behaviour::Handle handle)
+    {
+        suspend(handle, typeid(EventType).hash_code());
+    }
+
+    shared_ptr<EventType> await_resume()
+    {
+        return static_pointer_cast<EventType>(event);
+    }
+};
+
+/**
+ * @brief co_await delay(seconds) in a behaviour to continue after that much simulated time.
+ */
+inline DelayAwaiter delay(double seconds)
+{
+    return DelayAwaiter{seconds};
+}
+
+/**
+ * @brief co_await nextTick() in a behaviour to continue on the next tick.
+ */
+inline NextTickAwaiter nextTick()
+{
+    return NextTickAwaiter{};
+}
+
+/**
+ * @brief co_await nextEvent<EventType>() in a behaviour to continue once such an event is dispatched.
+ * @return shared_ptr<EventType> the event, when awaited
+ */
+template <typename EventType>
+inline EventAwaiter<EventType> nextEvent()
+{
+    return EventAwaiter<EventType>{};
+}
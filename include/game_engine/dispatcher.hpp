@@ -27,6 +27,14 @@ class EventDispatcher
     queue<shared_ptr<Event>> *front;     ///< front bugger, meant to have events read and handled from it
 
     mutex back_m; ///< write lock to atomize queue access
+
+    struct Waiter
+    {
+        weak_ptr<void> owner;
+        function<void(shared_ptr<Event>)> callback;
+    };
+    unordered_map<size_t, vector<Waiter>> waiters; ///< one shot waiters by event type
+    vector<Waiter> woken;
 public:
     unordered_set<shared_ptr<HandlerI>> handles; /// < handler objects to be notified by events
 
@@ -47,6 +55,15 @@ public:
      */
     void unregisterEventHandler(shared_ptr<HandlerI> handle);
 
+    /**
+     * @brief Call `callback` once, with the next dispatched event of the given type, after the handlers saw it.
+     * Only for the thread which dispatches.
+     * @param event_type typeid(EventType).hash_code()
+     * @param owner the wait is dropped if the owner is gone by then
+     * @param callback
+     */
+    void waitForEvent(size_t event_type, weak_ptr<void> owner, function<void(shared_ptr<Event>)> callback);
+
     /**
      * @brief Add `Event` to be sent to `Handler`s. Handlers will only recieve events when `dispatch()` is called.
      * @param e
@@ -18,7 +18,8 @@
 
 #include <box2d/box2d.h>
 
-#include <clock.h>   // clock/timer utility
+
+#include <typeindex>
 
 #include "std_includes.hpp"
 #include "vects.hpp" // Mathematical vectors
@@ -33,8 +34,84 @@ class Event;
 class EngineController;
 class GraphicSystem;
 class EventDispatcher;
+class JobSystem;
 #include "objects.hpp"
 #include "physics.hpp"
+#include "logger.hpp"
+#include "timer_wheel.hpp"
+#include "replay.hpp"
+#include "frame_pacer.hpp"
+#include "input.hpp"
+#include "engine_clock.hpp"
+#include "stats.hpp"
+#include "prefab.hpp"
+
+/**
+ * @brief Settings an Engine is constructed with.
+ */
+struct EngineConfig
+{
+    Vect2i window_size = {1024, 720};
+    Vect2f gravity = {0, 1024};
+    double tick_rate = 60; ///< frames per second the engine paces itself to, also the tick length used by step()
+    double render_rate = 0; ///< frames per second start() paces itself to, such as the display's refresh rate, 0 for tick_rate. Ticks follow the fixed step if one is set, else the frames.
+    double physics_rate = 0; ///< physics steps per second, independent of the tick rate. 0 to step physics once per tick.
+    bool headless = false; ///< no window, renderer or audio output and no frame pacing. Requires Engine::enable(true).
+    int worker_threads = -1; ///< threads in the engine's job system, -1 for one less than the number of cores
+    shared_ptr<JobSystem> job_system; ///< pool to share with other engines, if null the engine starts its own with worker_threads threads
+    bool pipelined = false; ///< simulate on a separate thread, one frame ahead of the thread which renders. See Engine::getPipelineStats().
+    uint32_t seed = 0; ///< seed of the engine's RNG, 0 for a random one
+    bool vsync = false; ///< also wait for the display when presenting. The engine paces itself to render_rate either way.
+    double time_limit = 0; ///< simulated seconds after which start() returns, 0 for no limit. Never cuts step() or replay() short.
+    int overload_frames = 3; ///< frames in a row over budget before the engine sheds load, 0 to never shed load
+    int max_skipped_renders = 1; ///< render frames skipped in a row while shedding load
+    int low_priority_stride = 4; ///< while shedding load, low priority objects loop on one tick out of this many
+};
+
+/**
+ * @brief Counters of the engine's overrun handling. Every decision it takes is counted here.
+ */
+struct LoadStats
+{
+    unsigned long overruns = 0;          ///< frames whose simulation and rendering took longer than a frame at render_rate
+    unsigned long capped_frames = 0;     ///< frames whose catch-up was capped at max_catchup_steps
+    double dropped_time = 0;             ///< simulated seconds dropped by capping, in total
+    unsigned long overload_periods = 0;  ///< times the engine started shedding load
+    unsigned long overloaded_frames = 0; ///< frames run while shedding load
+    unsigned long skipped_renders = 0;   ///< frames not rendered while shedding load
+    unsigned long throttled_loops = 0;   ///< loop() calls of low priority objects skipped while shedding load
+    bool overloaded = false;             ///< shedding load right now
+};
+
+/**
+ * @brief Frame timings of the pipelined mode in milliseconds, averaged over recent frames.
+ */
+struct PipelineStats
+{
+    double simulation = 0; ///< simulating and recording a frame
+    double render = 0;     ///< submitting a frame and presenting it
+    double frame = 0;      ///< wall time between presented frames
+    double recovered = 0;  ///< simulation + render - frame, the time won by overlapping the two
+};
+
+/**
+ * @brief A structural change requested during a tick. Recorded per thread and applied at the end of the tick.
+ */
+struct EngineCommand
+{
+    enum Type
+    {
+        REGISTER,
+        UNREGISTER,
+        REFRESH_LOOP,
+        REFRESH_ACTIVE,
+        REGISTER_HANDLER,
+        UNREGISTER_HANDLER
+    };
+    Type type;
+    shared_ptr<Object> obj;
+    shared_ptr<HandlerI> handle;
+};
 
 class HardwareEventBuilder
 {
@@ -45,53 +122,332 @@ public:
 class Engine : public std::enable_shared_from_this<Engine>
 {
     friend EngineController;
+    friend Object;
 
-    //thread_pool::static_pool workers;
-    unordered_set<shared_ptr<Object>> bucket;
-    unordered_set<shared_ptr<Object>> dead_bucket;
+    unordered_set<shared_ptr<Object>> bucket; // owns every registered object
+    enum LoopList
+    {
+        SERIAL_LOOPS,
+        PARALLEL_LOOPS,     // objects which are thread safe
+        LOW_SERIAL_LOOPS,   // low priority objects, throttled under overload
+        LOW_PARALLEL_LOOPS,
+        LOOP_LISTS
+    };
+    map<int, vector<Object *>> loops[LOOP_LISTS]; // registered objects with something to do in loop() by loop interval, owned by bucket
+    std::atomic<bool> ticking{false}; // set while a tick runs, structural changes are recorded instead of applied
+    std::thread::id tick_thread;     // thread running the tick, records into command_buffers[0]
+    static thread_local int parallel_depth; // parallel loop bodies running on this thread, of any engine
+    vector<vector<EngineCommand>> command_buffers; // one per job system thread, worker i records into i + 1
+    vector<EngineCommand> foreign_commands; // recorded by threads outside the job system
+    mutex foreign_m;
+    vector<EngineCommand> applying;  // commands of all threads, in the order they are applied
+    unordered_map<Object *, size_t> last_change; // index in `applying` of the last (un)register of each object
     shared_ptr<Object> root; ///< root object
-    double tick_delay;       // minimum time between updates
+    shared_ptr<EngineController> controller; // registered once the engine runs, needs the engine to be owned by a shared_ptr
+    EngineConfig config;
+    double fixed_delta = 0;  // length of a fixed simulation step, 0 when running with variable step
+    int max_catchup_steps = 5; // fixed steps allowed per frame before the backlog is dropped
+    double accumulator = 0;  // unsimulated time carried between frames in fixed step mode
+    std::atomic<unsigned long> tick_count{0}; // number of simulation ticks run so far, read by the render thread when pipelined
+    unsigned long physics_steps = 0; // physics steps run so far, when physics_rate is set
     std::mutex run;        // signifies the thread running the engine
-    Clock clock;
+    FramePacer pacer;
+    bool presenting = false; // start() runs its serial loop, events are followed up to the present reflecting them
+    bool free_running = false; // start() runs, the only time config.time_limit stops the engine
     std::atomic<bool> is_stopped; // set to true to stop engine
     std::mutex operation;   // can either be held when runing an update or changing engine settings
+    vector<pair<weak_ptr<void>, function<void()>>> next_tick; // callbacks for the start of the next tick
+    vector<pair<weak_ptr<void>, function<void()>>> next_tick_running;
+    uint32_t seed;
+    unique_ptr<ReplayWriter> recorder; // set while recording
+    unique_ptr<ReplayReader> player;   // set while replaying, replaces SDL as the event source
+    PipelineStats pipeline_stats;
+    LoadStats load;           // updated by the simulating thread
+    LoadStats load_published; // copy of load for other threads, updated once per frame
+    RollingHistogram input_times, simulation_times, physics_times, render_times, frame_times; // guarded by stats_m
+    EngineStats counts_published; // counters of the last frame, histograms left empty
+    double physics_time = 0;  // milliseconds spent in physics since the last recordFrame() of the simulating thread
+    int overrun_streak = 0;   // frames in a row over budget
+    int calm_streak = 0;      // frames in a row well within budget
+    int skipped_in_row = 0;   // render frames skipped in a row
+    mutex stats_m; // guards pipeline_stats and load_published, written by both threads of the pipelined mode
+
+    /**
+     * @brief Drain the SDL event queue into the dispatcher. Stops the engine on SDL_QUIT.
+     * Records the events while recording, and takes them from the recording instead while replaying.
+     * Headless engines leave the SDL queue alone, since it belongs to the main thread and they may run on any.
+     */
+    void pollEvents();
+
+    /**
+     * @brief Advance the simulation by a frame's worth of time, in one variable step or as many fixed steps as fit.
+     * While the clock is paused, runs a single tick of zero length.
+     * @param delta wall time of the frame, turned into simulated time by the clock
+     * @return float interpolation factor for rendering the frame
+     */
+    float simulate(double delta);
+
+    /**
+     * @brief Main loop of the pipelined mode. The simulation runs on a new thread and records draw lists,
+     * the calling thread keeps polling events and submitting the lists, since SDL wants both on the thread that made the window.
+     */
+    void runPipelined();
+
+    /**
+     * @brief Count overruns of a frame and enter or leave the overloaded state. Called once per frame.
+     * @param work seconds spent simulating and rendering the frame
+     */
+    void trackLoad(double work);
+
+    /**
+     * @brief True if this frame's rendering should be skipped to shed load.
+     */
+    bool skipRender();
+
+    /**
+     * @brief Loop every stride-th object of a loop list, starting at first. Unless they loop on every tick,
+     * objects are given the time since they last looped.
+     */
+    void runLoops(LoopList list, vector<Object *> &objects, size_t first, size_t stride, double delta);
+
+    /**
+     * @brief Length of the ticks step() runs, and of a frame in virtual time.
+     */
+    double tickLength()
+    {
+        return fixed_delta > 0 ? fixed_delta : 1.0 / config.tick_rate;
+    }
+
+    double frameRate()
+    {
+        return config.render_rate > 0 ? config.render_rate : config.tick_rate;
+    }
+
+    /**
+     * @brief Add a frame's timings in milliseconds to the histograms, skipping negative ones. The thread which simulates
+     * passes its simulation time, physics included, and publishes the counters along with it.
+     */
+    void recordFrame(double input, double simulation, double render, double frame);
+
+    /**
+     * @brief Step physics by delta, or at physics_rate up to the current simulated time if it is set.
+     * Then propagates the world transforms for rendering.
+     */
+    void updatePhysics(double delta);
+
+    /**
+     * @brief Types whose loop() does nothing without a loop behaviour. Looked up by exact type, so subclasses are not covered.
+     */
+    static set<std::type_index> &passiveTypes();
+
+    /**
+     * @brief True if the object is active, and has a loop behaviour or is of a type which is not passive.
+     */
+    static bool needsLoop(Object *obj);
+
+    /**
+     * @brief Put the object in the loop list it belongs in, or take it out of them, in O(1).
+     * Deferred to the end of the tick while one is running.
+     */
+    void refreshLoop(Object *obj);
+
+    /**
+     * @brief Bring the engine in line with whether the object is active: its loop, body, handlers, timers and behaviours.
+     * Deferred to the end of the tick while one is running.
+     */
+    void refreshActive(Object *obj);
+
+    /**
+     * @brief Start the object's behaviours on the next tick, if it has any.
+     */
+    void startBehaviours(Object *obj);
+
+    /**
+     * @brief Queue a structural change in the calling thread's command buffer.
+     */
+    void record(EngineCommand command);
+
+    /**
+     * @brief The sync point at the end of a tick. Applies the recorded commands of all threads in one batch,
+     * skipping (un)registrations later overridden for the same object.
+     */
+    void applyCommands();
+
+    void registerNow(shared_ptr<Object> obj);
+
+    void unregisterNow(shared_ptr<Object> obj);
+
+    /**
+     * @brief Point a subtree at an engine, or at none, ahead of its recorded (un)register being applied.
+     * Objects pointing at another engine are left alone.
+     */
+    void claimTree(Object *obj, Engine *engine);
+
+    /**
+     * @brief Swap-remove the object from its loop list.
+     */
+    void removeLoop(Object *obj);
 
 public:
     shared_ptr<GraphicSystem> gsys;
     shared_ptr<EventDispatcher> disp;
     shared_ptr<World> world;
+    shared_ptr<JobSystem> workers; ///< runs the loops of thread safe objects, free for user jobs as well
+    shared_ptr<TransformSystem> transforms; ///< world transforms of all registered Object2Ds, updated at the end of each tick's physics
+    shared_ptr<EngineClock> clock; ///< simulated time, with time scale and pause. step() runs whole ticks regardless.
+    shared_ptr<InputSystem> input; ///< timestamps events as they arrive, see InputSystem::addLatch() for late latching
+    shared_ptr<TimerWheel> timers; ///< advanced by the simulated time of each tick, see Object::after() and Object::every()
+    std::mt19937 rng; ///< use instead of rand(), so recordings replay the same
 
     /**
      * @brief Call before creating any engine objects. Enables SDL utilities and other global state required for the Engine class to work.
+     * Reference counted, only the first call initializes, so independent users of engines in one process can each call it.
+     * @param headless use SDL's dummy video and audio drivers, for machines without a display or sound card. Only honoured by the first call.
      */
-    static int enable()
+    static int enable(bool headless = false);
+
+    /**
+     * @brief Call after all engine objects are destroyed, once per enable(). The last call dissables SDL utilities and other global state.
+     */
+    static void disable();
+
+    Engine(Vect2i window_size = {1024, 720}, Vect2f gravity = {0, 1024}, double tick_rate = 60);
+
+    Engine(EngineConfig config);
+
+    ~Engine();
+
+    void start();
+
+    /**
+     * @brief Counters and frame time histograms, as of the last frame. Cheap enough to call every frame, from any thread.
+     * @return EngineStats
+     */
+    EngineStats getStats();
+
+    /**
+     * @brief Timings of the pipelined mode, see EngineConfig::pipelined. All zero in other modes.
+     * @return PipelineStats
+     */
+    PipelineStats getPipelineStats()
     {
-        if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS | SDL_INIT_AUDIO) < 0)
-        {
-            std::cerr << "Failed to initialize SDL_subsystems: " << SDL_GetError() << '\n';
-            return 1;
-        }
-        if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 8, 2048) < 0)
-        {
-            std::cerr << "Failed to initialize SDL_mixer: " << Mix_GetError() << '\n';
-            return 1;
-        }
-        srand(time(NULL));
-        return 0;
+        std::lock_guard<mutex> lock(stats_m);
+        return pipeline_stats;
     }
 
     /**
-     * @brief Call after all engine objects are destroyed. Dissables SDL utilities and other global state required for the Engine class to work.
+     * @brief Overrun and load shedding counters.
+     * @return LoadStats
      */
-    static void disable()
+    LoadStats getLoadStats()
     {
-        Mix_CloseAudio();
-        SDL_Quit();
+        std::lock_guard<mutex> lock(stats_m);
+        return load_published;
     }
 
-    Engine(Vect2i window_size = {1024, 720}, Vect2f gravity = {0, 1024}, double tick_rate = 60);
+    /**
+     * @brief Frame interval and jitter statistics of start().
+     * @return PacerStats
+     */
+    PacerStats getPacerStats()
+    {
+        return pacer.getStats();
+    }
 
-    void start();
+    /**
+     * @brief Input to present latency percentiles of start(), not measured when pipelined.
+     * @return LatencyStats
+     */
+    LatencyStats getInputLatency()
+    {
+        return input->getLatency();
+    }
+
+    /**
+     * @brief Pace frames by sleeping alone, at a lower rate, for idle menus. Takes effect on the next frame.
+     * @param low_power
+     */
+    void setLowPower(bool low_power)
+    {
+        pacer.setLowPower(low_power);
+    }
+
+    /**
+     * @brief Run ticks back to back on the calling thread, as fast as the CPU allows.
+     * Each tick simulates 1/tick_rate seconds (or the fixed step, if one is set), regardless of how long it took.
+     * @param ticks number of ticks to run
+     * @return double ticks per second achieved
+     * @throws std::runtime_error if the engine is already running
+     */
+    double step(unsigned long ticks = 1);
+
+    /**
+     * @brief Step many engines at once, each as a job on the pool. Engines meant for this are headless, and
+     * best share the pool through EngineConfig::job_system, so their own parallel loops run on it as well.
+     * @param engines
+     * @param ticks ticks to run each engine for
+     * @param pool
+     * @return double ticks per second achieved by all the engines together
+     */
+    static double stepAll(const vector<shared_ptr<Engine>> &engines, unsigned long ticks, JobSystem &pool);
+
+    /**
+     * @brief Run as many ticks as fit in the given amount of simulated time. See step().
+     * @param seconds simulated time to advance by
+     * @return double ticks per second achieved
+     */
+    double runFor(double seconds);
+
+    /**
+     * @brief Run logic and physics at a fixed rate, independent of the frame rate.
+     * Frame time is accumulated and consumed in steps of 1/tick_rate, and the renderer
+     * interpolates graphic objects between the last two steps.
+     * @param tick_rate simulation steps per second, 0 to go back to one variable step per frame
+     * @param max_catchup_steps steps allowed in a single frame, any time left over past that is dropped
+     */
+    void setFixedStep(double tick_rate, int max_catchup_steps = 5);
+
+    /**
+     * @brief Number of simulation ticks run since the engine was created.
+     */
+    unsigned long getTickCount()
+    {
+        return tick_count;
+    }
+
+    uint32_t getSeed()
+    {
+        return seed;
+    }
+
+    /**
+     * @brief Reseed the engine's RNG.
+     * @param seed
+     */
+    void setSeed(uint32_t seed);
+
+    /**
+     * @brief Record every hardware event from now on to a file, with the tick it is dispatched on and the RNG seed.
+     * Switches to fixed step at the configured tick rate if no fixed step is set, reseeds the RNG with the
+     * current seed and turns off the pipelined mode, so that the ticks can be reproduced.
+     * @param path
+     * @throws std::runtime_error if the file can not be created
+     */
+    void startRecording(string path);
+
+    /**
+     * @brief Finish the recording, if one is running.
+     */
+    void stopRecording();
+
+    /**
+     * @brief Play a recording back as fast as possible, see step(). The engine has to be set up the same as
+     * when the recording started, and SDL events are ignored meanwhile.
+     * @param path
+     * @return double ticks per second achieved
+     * @throws std::runtime_error if the file can not be read or is not a recording
+     */
+    double replay(string path);
 
     void stop()
     {
@@ -99,15 +455,62 @@ public:
     }
 
     /**
-     * @brief Add object for updates and initialization
+     * @brief Declare that objects of exactly type T do nothing in loop() unless given a loop behaviour.
+     * The engine then leaves them out of its loop lists, so they cost nothing per tick.
+     * Call before registering objects of that type. The engine's own passive types are registered already.
+     * @tparam T
+     */
+    template <typename T>
+    static void setPassive()
+    {
+        passiveTypes().emplace(typeid(T));
+    }
+
+    /**
+     * @brief Add object for updates and initialization. Registering an object twice has no effect.
+     * During a tick, the registration takes effect at the end of the tick, the object's engine is set right away.
      * @param obj
      */
     void registerObj(shared_ptr<Object> obj);
 
+    /**
+     * @brief Remove object and its children from updates and all systems.
+     * During a tick, takes effect at the end of the tick.
+     * @param obj
+     */
     void unregisterObj(shared_ptr<Object> obj);
 
+    /**
+     * @brief Start notifying a handler of events. Deferred to the end of the tick while one is running.
+     * @param handle
+     */
+    void registerHandler(shared_ptr<HandlerI> handle);
+
+    void unregisterHandler(shared_ptr<HandlerI> handle);
+
+    /**
+     * @brief Call `callback` at the start of the next tick, on the thread running it. Only for the thread running the engine.
+     * @param owner the call is dropped if the owner is gone by then
+     * @param callback
+     */
+    void onNextTick(weak_ptr<void> owner, function<void()> callback);
+
+    /**
+     * @brief Loop all registered objects which need it. Objects which declare themselves thread safe are looped in parallel on the job system.
+     * Objects with a loop interval of n take turns, 1/n of them looping on each tick, so that low rate work is spread over the ticks.
+     * While the engine sheds load, low priority objects loop low_priority_stride times less often still.
+     * Objects registered during the update are first looped on the next one.
+     * @param delta
+     */
     void update(double delta);
 
+    /**
+     * @brief Run one simulation tick, excluding physics: resumes behaviours waiting for it, loops objects, fires due timers, dispatches events
+     * and applies the structural changes made meanwhile.
+     * @param delta time simulated by the tick
+     */
+    void tick(double delta);
+
     // Composition with root object
     
     inline void addChild(shared_ptr<Object> child)
@@ -164,13 +567,25 @@ public:
     }
 #endif
     template <typename T = Object>
-    inline shared_ptr<T> getChild(string path)
+    inline shared_ptr<T> getChild(const NodePath &path)
+    {
+        return root->getChild<T>(path);
+    }
+
+    template <typename T = Object>
+    inline shared_ptr<T> getChild(std::string_view path)
     {
         return root->getChild<T>(path);
     }
 
     template <typename T = Object>
-    inline shared_ptr<T> get(string path)
+    inline shared_ptr<T> get(const NodePath &path)
+    {
+        return getChild<T>(path);
+    }
+
+    template <typename T = Object>
+    inline shared_ptr<T> get(std::string_view path)
     {
         return getChild<T>(path);
     }
@@ -192,7 +607,7 @@ public:
      * @return shared_ptr<Object> the removed child
      * @throws std::out_of_range exception if no child has that name
      */
-    inline shared_ptr<Object> removeChild(string name)
+    inline shared_ptr<Object> removeChild(const string &name)
     {
         return root->removeChild(name);
     }
@@ -0,0 +1,106 @@
+/**
+ * @file engine_clock.hpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief The engine's time source, with time scale, pause and virtual time.
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include "std_includes.hpp"
+
+// defined here
+class EngineClock;
+
+/**
+ * @brief Turns the wall time between frames into the time the engine simulates. Everything in the
+ * engine measures time by it: ticks, physics, timers and objects' loops. Nothing reads the wall clock directly,
+ * so the same ticks play out alike at any speed, headless or replayed.
+ * Set from the thread running the engine, or between runs.
+ */
+class EngineClock
+{
+    double scale = 1;
+    bool paused = false;
+    bool virtual_time = false;
+    double time = 0;      // simulated seconds so far
+    double real_time = 0; // wall seconds of the frames so far, paused ones included
+
+public:
+    /**
+     * @brief Simulated time for a frame.
+     * @param real_delta wall seconds since the previous frame
+     * @param tick_delta length of one tick, what a frame lasts in virtual time
+     * @return double seconds to simulate, 0 while paused
+     */
+    double frame(double real_delta, double tick_delta);
+
+    /**
+     * @brief Count a simulated tick. Called by the engine as each tick starts.
+     * @param delta
+     */
+    void advance(double delta)
+    {
+        time += delta;
+    }
+
+    /**
+     * @brief Simulated seconds so far.
+     */
+    double now()
+    {
+        return time;
+    }
+
+    /**
+     * @brief Wall seconds spent in frames so far.
+     */
+    double realTime()
+    {
+        return real_time;
+    }
+
+    /**
+     * @brief Simulate `scale` seconds per second of wall time, such as 0.25 for slow motion or 4 to fast-forward.
+     * @param scale
+     * @throws std::out_of_range if scale is negative
+     */
+    void setScale(double scale);
+
+    double getScale()
+    {
+        return scale;
+    }
+
+    /**
+     * @brief While paused, frames run ticks of zero length: events are dispatched and behaviours waiting
+     * for the next tick resume, but loops get a delta of 0, timers do not advance and physics does not step.
+     * @param paused
+     */
+    void setPaused(bool paused)
+    {
+        this->paused = paused;
+    }
+
+    bool isPaused()
+    {
+        return paused;
+    }
+
+    /**
+     * @brief Advance one tick per frame, however long the frame took, instead of following the wall clock.
+     * @param virtual_time
+     */
+    void setVirtual(bool virtual_time)
+    {
+        this->virtual_time = virtual_time;
+    }
+
+    bool isVirtual()
+    {
+        return virtual_time;
+    }
+};
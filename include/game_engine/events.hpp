@@ -67,7 +67,7 @@ class HandlerI
 public:
     size_t event_type;
     virtual void operator()(shared_ptr<Event> e) = 0;
-    virtual void setOwner(weak_ptr<Object> obj) = 0;
+    virtual void setOwner(Object *obj) = 0;
     virtual void clearOwner() = 0;
 };
 
@@ -79,23 +79,25 @@ template <typename EventType, typename OwnerType>
 class Handler : public HandlerI
 {
     friend void Object::attachHandler(shared_ptr<HandlerI> handle);
-    virtual void setOwner(weak_ptr<Object> obj) final
+    virtual void setOwner(Object *obj) final
     {
-        owner_view = dynamic_pointer_cast<OwnerType>(obj.lock());
-        if(!owner_view.lock())
+        if(dynamic_cast<OwnerType *>(obj) == nullptr)
             throw std::runtime_error("Attempt to assign handler to incorrect owner type");
+        owner = obj->getHandle();
     }
     virtual void clearOwner() final
     {
-        owner_view.reset();
+        owner = ObjectHandle();
     }
-    weak_ptr<OwnerType> owner_view;
+    ObjectHandle owner; ///< checked to be an OwnerType by setOwner()
 protected:
+    /**
+     * @brief The owner, null once it is destroyed. The handle is checked before any reference is taken.
+     * @return shared_ptr<OwnerType>
+     */
     shared_ptr<OwnerType> getOwner()
     {
-        //if(!owner_view.lock())
-        //    throw std::runtime_error("Owner view is invalid");
-        return owner_view.lock();
+        return static_pointer_cast<OwnerType>(owner.lock());
     }
 public:
     Handler()
@@ -104,7 +106,7 @@ public:
     }
     virtual void operator()(shared_ptr<Event> e) final
     {
-        if(owner_view.lock())
+        if(owner.get())
             handle(static_pointer_cast<EventType>(e));
     }
 
@@ -0,0 +1,108 @@
+/**
+ * @file frame_pacer.hpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief Paces frames by sleeping through most of the budget and spinning only at the end.
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include "std_includes.hpp"
+
+// defined here
+struct PacerStats;
+class FramePacer;
+
+/**
+ * @brief Frame interval statistics in milliseconds, since the pacer was created or last reset.
+ */
+struct PacerStats
+{
+    unsigned long frames = 0;
+    double mean = 0;       ///< average interval between frames
+    double jitter = 0;     ///< standard deviation of the interval
+    double worst = 0;      ///< largest difference between an interval and the period
+    unsigned long late = 0; ///< frames which took over one and a half periods
+    double oversleep = 0;  ///< how long the OS typically sleeps past what was asked, sizes the spin window
+    double spin = 0;       ///< average time spent spinning per frame
+};
+
+/**
+ * @brief Waits out the rest of each frame's budget. Sleeps until shortly before the deadline and
+ * spins for the rest, with the spin window sized by how much the OS oversleeps. In low power mode the
+ * pacer only sleeps, at a lower rate, for menus and other idle screens.
+ */
+class FramePacer
+{
+    typedef std::chrono::steady_clock steady_clock;
+
+    double period;
+    double low_power_period;
+    bool low_power = false;
+    double min_spin = 0.0002; ///< spin window never shrinks below this, in seconds
+    double oversleep = 0.001; ///< running estimate, starts pessimistic
+    bool started = false;
+    steady_clock::time_point deadline;
+    steady_clock::time_point last;
+    function<void()> idle;    ///< called now and then while sleeping
+    double idle_interval = 0.001;
+
+    mutex stats_m; ///< stats can be read from other threads
+    unsigned long frames = 0;
+    double sum = 0, sum_squares = 0, worst = 0, spin_total = 0;
+    unsigned long late = 0;
+
+    static double seconds(steady_clock::duration d)
+    {
+        return std::chrono::duration<double>(d).count();
+    }
+
+public:
+    /**
+     * @brief Construct a new FramePacer
+     * @param rate frames per second, 0 to not wait at all
+     * @param low_power_rate frames per second in low power mode
+     */
+    FramePacer(double rate = 60, double low_power_rate = 20);
+
+    /**
+     * @brief Block until the current frame's deadline.
+     * @return double seconds since the previous call returned
+     */
+    double wait();
+
+    /**
+     * @brief Start pacing from now on, forgetting the previous deadline.
+     */
+    void reset();
+
+    /**
+     * @brief Frames per second to pace to, 0 to not wait at all.
+     */
+    void setRate(double rate);
+
+    /**
+     * @brief Have something done regularly while the pacer sleeps, such as pumping input.
+     * @param idle callable, empty to just sleep
+     * @param interval seconds between calls
+     */
+    void setIdle(function<void()> idle, double interval = 0.001);
+
+    /**
+     * @brief Sleep only, never spin, at the low power rate.
+     * @param low_power
+     */
+    void setLowPower(bool low_power);
+
+    bool isLowPower()
+    {
+        return low_power;
+    }
+
+    PacerStats getStats();
+
+    void resetStats();
+};
@@ -10,26 +10,109 @@
 
 // defined here
 class GraphicSystem;
+struct DrawCommand;
+class FramePipeline;
 
 // extern
 class GraphicObject;
 class Texture;
+struct TextureAtlas;
+class TransformSystem;
+
+/**
+ * @brief A textured quad, recorded so it can be drawn later, possibly by another thread.
+ */
+struct DrawCommand
+{
+    shared_ptr<TextureAtlas> atlas; ///< keeps the texture alive until the command is drawn
+    SDL_Rect src;
+    SDL_Rect dest;
+};
+
+/**
+ * @brief The draw commands of one frame, in draw order.
+ */
+typedef vector<DrawCommand> DrawList;
+
+/**
+ * @brief Double buffered hand-off of draw lists from the simulation thread to the render thread.
+ * The simulation fills one list while the renderer submits the other, and waits for the renderer
+ * before publishing, so rendering is never more than one frame behind.
+ */
+class FramePipeline
+{
+    DrawList buffers[2];
+    int write_index = 0;
+    bool frame_ready = false; ///< buffers[1 - write_index] holds a frame not yet taken by the renderer
+    bool reading = false;     ///< the renderer is submitting buffers[1 - write_index]
+    bool stopped = false;
+    mutex m;
+    std::condition_variable changed;
+
+public:
+    /**
+     * @brief The list the simulation thread records into.
+     */
+    DrawList &back()
+    {
+        return buffers[write_index];
+    }
+
+    /**
+     * @brief Hand back() over to the renderer. Blocks while the renderer still has the previous frame.
+     * @return false if the pipeline was stopped
+     */
+    bool publish();
+
+    /**
+     * @brief Take the newest frame for submission, waiting for it at most `timeout`.
+     * @return const DrawList* the frame, null on timeout or if the pipeline was stopped. Call release() when done with a frame.
+     */
+    const DrawList *acquire(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Done with the acquired frame. Its commands are dropped here, so that an atlas they were the last users of
+     * is destroyed by the renderer rather than while it draws.
+     */
+    void release();
+
+    /**
+     * @brief Wake up and fail all waiting calls.
+     */
+    void stop();
+};
 
 class GraphicSystem
 {
-    SDL_Renderer *render;
-    SDL_Window *window;
+    SDL_Renderer *render = nullptr;
+    SDL_Window *window = nullptr;
     Vect2i window_size;
 public:
     Vect2i camera_pos;
     float camera_zoom = 1;
+    TransformSystem *transforms = nullptr; ///< world transforms of the objects, set by the engine
+    float alpha = 1; ///< interpolation factor between the previous and current simulation step, used while drawing
     /**
      * Bucket for graphic objects, stored along their draw height/z.
      * Lowest z values are drawn first and occluded by higher z vallues.
      */
     set<pair<int, shared_ptr<GraphicObject>>> bucket;
 
-    GraphicSystem(Vect2i window_size);
+    /**
+     * @brief Construct a new GraphicSystem
+     * @param window_size
+     * @param headless create no window or renderer, textures are only decoded for their size and nothing is drawn
+     * @param vsync present in sync with the display
+     */
+    GraphicSystem(Vect2i window_size, bool headless = false, bool vsync = false);
+
+    /**
+     * @brief True if the system has no renderer to draw to.
+     */
+    bool isHeadless()
+    {
+        return render == nullptr;
+    }
 
     shared_ptr<Texture> loadTexture(string filepath);
 
@@ -47,5 +130,29 @@ public:
         return Vect2i((pos.x - camera_pos.x + window_size.x / 2) * camera_zoom, (pos.y - camera_pos.y + window_size.y / 2) * camera_zoom);
     }
 
-    void update();
+    /**
+     * @brief Remember the current position of every graphic object as its previous position.
+     * Called before each fixed simulation step, so that frames can be interpolated between steps.
+     */
+    void snapshot();
+
+    /**
+     * @brief Draw all graphic objects and present the frame.
+     * @param alpha how far the frame is between the previous and the current simulation step, in [0, 1]
+     */
+    void update(float alpha = 1);
+
+    /**
+     * @brief Record the draw commands of all graphic objects, without touching the renderer.
+     * Only objects which implement GraphicObject::record() are included.
+     * @param list list to append to, cleared first
+     * @param alpha interpolation factor, see update()
+     */
+    void record(DrawList &list, float alpha = 1);
+
+    /**
+     * @brief Draw a recorded frame and present it. Must be called on the thread that owns the renderer.
+     * @param list
+     */
+    void submit(const DrawList &list);
 };
@@ -0,0 +1,113 @@
+/**
+ * @file input.hpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief Timestamped input, late latching and input to present latency.
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include "std_includes.hpp"
+#include "vects.hpp"
+
+// defined here
+struct InputSample;
+struct InputState;
+struct LatencyStats;
+class InputSystem;
+
+/**
+ * @brief An SDL event and when it was taken off the OS queue.
+ */
+struct InputSample
+{
+    SDL_Event event;
+    std::chrono::steady_clock::time_point arrival;
+    unsigned long tick = 0; ///< tick the event was handed to, once taken
+    bool latched = false;   ///< seen by a late latch callback, so a present already reflects it
+};
+
+/**
+ * @brief Input state right before a frame is submitted.
+ */
+struct InputState
+{
+    Vect2i mouse;
+    Uint32 buttons;    ///< SDL_BUTTON masks
+    const Uint8 *keys; ///< indexed by SDL_Scancode
+    int key_count;
+};
+
+/**
+ * @brief Milliseconds from an event's arrival to the present of the first frame reflecting it, over recent events.
+ */
+struct LatencyStats
+{
+    unsigned long samples = 0;
+    double p50 = 0;
+    double p90 = 0;
+    double p99 = 0;
+    double max = 0;
+};
+
+/**
+ * @brief Takes events off the SDL queue as often as it is pumped, stamping each with its arrival time.
+ * SDL only allows this on the thread which made the window, so instead of a thread of its own the
+ * engine pumps it while the frame pacer sleeps, and once more right before submitting a frame.
+ */
+class InputSystem
+{
+    static const size_t latency_window = 1024; ///< latencies kept for the percentiles
+
+    vector<InputSample> pending;   ///< arrived, not yet handed to a tick
+    vector<InputSample> in_flight; ///< handed to a tick, not yet presented
+    vector<pair<weak_ptr<void>, function<void(const InputState &)>>> latches;
+    vector<std::chrono::steady_clock::time_point> latched_arrivals; ///< arrivals of events latched for the coming present
+    vector<double> latencies; ///< ring of the latest latencies in milliseconds
+    size_t latency_next = 0;
+    unsigned long latency_count = 0;
+    mutex stats_m;
+
+    void measure(std::chrono::steady_clock::time_point arrival, std::chrono::steady_clock::time_point present);
+
+public:
+    /**
+     * @brief Move waiting events from SDL's queue to the pending list, stamped with the current time.
+     */
+    void pump();
+
+    /**
+     * @brief Pump, then take the pending events, to be dispatched by the given tick.
+     * @param tick
+     * @param measured follow the events up to the present reflecting them, false where frames are not presented in tick order
+     * @return vector<InputSample>
+     */
+    vector<InputSample> take(unsigned long tick, bool measured = true);
+
+    /**
+     * @brief Call `callback` right before every frame is submitted, with the freshest input. For render side
+     * state such as a cursor or the camera, the simulation sees the same input on its next tick.
+     * Not called in the pipelined mode, where frames are recorded before they are submitted.
+     * @param owner the callback is dropped once the owner is gone, empty to keep it for good
+     * @param callback
+     */
+    void addLatch(weak_ptr<void> owner, function<void(const InputState &)> callback);
+
+    /**
+     * @brief Pump once more and run the late latch callbacks. Called by the engine right before submitting a frame.
+     */
+    void latch();
+
+    /**
+     * @brief Record the latency of the events reflected by the frame just presented.
+     * @param tick ticks run so far, events handed to earlier ticks are reflected
+     */
+    void presented(unsigned long tick);
+
+    LatencyStats getLatency();
+};
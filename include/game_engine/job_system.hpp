@@ -0,0 +1,189 @@
+/**
+ * @file job_system.hpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief Work-stealing thread pool, with task groups and parallel for.
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include <deque>
+
+#include "std_includes.hpp"
+
+// defined here
+class JobSystem;
+class TaskGroup;
+
+/**
+ * @brief Pool of worker threads, each with its own job deque. Workers take jobs from the back of
+ * their own deque and steal from the front of the others' when they run dry.
+ * Threads waiting on a TaskGroup run jobs too, so a pool with 0 workers runs everything on the caller.
+ */
+class JobSystem
+{
+    struct Job
+    {
+        function<void()> fn;
+        TaskGroup *group;
+    };
+
+    struct Queue
+    {
+        mutex m;
+        std::deque<Job> jobs;
+    };
+
+    vector<unique_ptr<Queue>> queues; ///< one per worker, plus one for submits from outside the pool
+    vector<std::thread> threads;
+    std::atomic<bool> stopping;
+    std::atomic<int> queued;          ///< jobs sitting in any queue
+    std::atomic<unsigned> next_queue; ///< round robin target for submits from outside the pool
+    mutex sleep_m;
+    std::condition_variable wake;
+
+    void workerLoop(int index);
+
+    /**
+     * @brief Run a single job, preferring the caller's own queue.
+     * @param index queue of the calling thread
+     * @return true if a job was run
+     */
+    bool runOne(int index);
+
+public:
+    /**
+     * @brief Construct a new JobSystem
+     * @param worker_count worker threads to start, -1 for one less than the number of cores
+     */
+    JobSystem(int worker_count = -1);
+
+    ~JobSystem();
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    /**
+     * @brief Number of threads which run jobs, the workers and the waiting thread.
+     */
+    unsigned concurrency()
+    {
+        return threads.size() + 1;
+    }
+
+    /**
+     * @brief Index of the worker the calling thread is, -1 if it is not a worker of any pool.
+     */
+    static int currentWorker();
+
+    /**
+     * @brief The pool the calling thread is a worker of, null if none.
+     */
+    static JobSystem *currentPool();
+
+    /**
+     * @brief Queue a job. Jobs submitted by a worker go to the back of its own deque.
+     * @param job callable to run, which must not throw unless it is part of a group
+     * @param group group to notify when the job finishes, and to hand an exception out of it to, may be null
+     */
+    void submit(function<void()> job, TaskGroup *group = nullptr);
+
+    /**
+     * @brief Run jobs until the group has none unfinished.
+     * @param group
+     */
+    void wait(TaskGroup &group);
+
+    /**
+     * @brief Call f(i) for every i in [begin, end), split into chunks of `grain` indices spread across the pool.
+     * Returns once all calls finished, then rethrows the first exception out of a call, if any.
+     * @param begin first index
+     * @param end one past the last index
+     * @param grain indices per job, larger values mean less scheduling overhead but coarser balancing
+     * @param f callable taking a size_t
+     */
+    template <typename F>
+    void parallelFor(size_t begin, size_t end, size_t grain, F &&f);
+};
+
+/**
+ * @brief Set of jobs which can be waited on together. A job which throws still counts as finished, and the first
+ * exception is rethrown by wait().
+ */
+class TaskGroup
+{
+    friend JobSystem;
+    JobSystem &jobs;
+    std::atomic<int> remaining;
+    mutex error_m;
+    std::exception_ptr error; ///< first exception out of a job, until wait() rethrows it
+
+public:
+    TaskGroup(JobSystem &jobs) : jobs(jobs), remaining(0) {}
+
+    /**
+     * @brief Waits for unfinished jobs, a group must not be destroyed while they run.
+     * An exception not rethrown by wait() is dropped.
+     */
+    ~TaskGroup()
+    {
+        jobs.wait(*this);
+    }
+
+    /**
+     * @brief Submit a job as part of the group.
+     * @param job
+     */
+    void run(function<void()> job)
+    {
+        jobs.submit(std::move(job), this);
+    }
+
+    /**
+     * @brief Block until every job in the group finished, running queued jobs meanwhile.
+     * @throws the first exception thrown by a job of the group since the last wait()
+     */
+    void wait()
+    {
+        jobs.wait(*this);
+        std::exception_ptr failed;
+        {
+            std::lock_guard<mutex> lock(error_m);
+            failed.swap(error);
+        }
+        if (failed)
+            std::rethrow_exception(failed);
+    }
+};
+
+template <typename F>
+void JobSystem::parallelFor(size_t begin, size_t end, size_t grain, F &&f)
+{
+    if (begin >= end)
+        return;
+    if (grain == 0)
+        grain = 1;
+    if (threads.empty() || end - begin <= grain)
+    {
+        for (size_t i = begin; i < end; i++)
+            f(i);
+        return;
+    }
+    TaskGroup group(*this);
+    for (size_t chunk = begin + grain; chunk < end; chunk += grain)
+    {
+        size_t chunk_end = chunk + grain < end ? chunk + grain : end;
+        group.run([&f, chunk, chunk_end]()
+        {
+            for (size_t i = chunk; i < chunk_end; i++)
+                f(i);
+        });
+    }
+    // the first chunk runs on the caller
+    for (size_t i = begin; i < begin + grain; i++)
+        f(i);
+    group.wait();
+}
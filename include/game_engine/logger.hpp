@@ -0,0 +1,208 @@
+/**
+ * @file logger.hpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief Asynchronous, leveled logging. Safe to call from the engine loop.
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include "std_includes.hpp"
+
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO  2
+#define LOG_LEVEL_WARN  3
+#define LOG_LEVEL_ERROR 4
+#define LOG_LEVEL_OFF   5
+
+// Calls below this level are removed by the preprocessor, arguments and all.
+#ifndef GAME_ENGINE_LOG_LEVEL
+#define GAME_ENGINE_LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// defined here
+struct LogArg;
+struct LogRecord;
+class LogRing;
+class Logger;
+
+/**
+ * @brief A single argument of a log record. Strings are kept by pointer, so only pass literals
+ * or strings which outlive the logger.
+ */
+struct LogArg
+{
+    enum Type : uint8_t
+    {
+        INT,
+        UINT,
+        DOUBLE,
+        STR
+    };
+    Type type = INT;
+    union
+    {
+        int64_t i;
+        uint64_t u;
+        double d;
+        const char *s;
+    };
+
+    LogArg() : i(0) {}
+
+    template <typename T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, int>::type = 0>
+    LogArg(T value) : type(INT), i(value) {}
+
+    template <typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value, int>::type = 0>
+    LogArg(T value) : type(UINT), u(value) {}
+
+    template <typename T, typename std::enable_if<std::is_floating_point<T>::value, int>::type = 0>
+    LogArg(T value) : type(DOUBLE), d(value) {}
+
+    LogArg(const char *value) : type(STR), s(value) {}
+};
+
+/**
+ * @brief Fixed size binary log entry. Formatting is deferred to the logger thread.
+ */
+struct LogRecord
+{
+    static const int max_args = 4;
+    uint64_t timestamp;  ///< nanoseconds since the logger was created
+    const char *format;  ///< format string, `{}` is replaced by the next argument. Must be a literal.
+    uint8_t level;
+    uint8_t arg_count;
+    LogArg args[max_args];
+};
+
+/**
+ * @brief Single producer, single consumer ring of log records. Each logging thread owns one.
+ */
+class LogRing
+{
+public:
+    static const size_t capacity = 1024; ///< must be a power of two
+private:
+    LogRecord records[capacity];
+    std::atomic<size_t> head{0}; ///< next slot to write, only changed by the producer
+    std::atomic<size_t> tail{0}; ///< next slot to read, only changed by the consumer
+public:
+    std::atomic<uint64_t> dropped{0}; ///< records lost because the ring was full
+
+    /**
+     * @brief Append a record. Never blocks, if the ring is full the record is dropped.
+     * @return true if the record was stored
+     */
+    bool push(const LogRecord &record);
+
+    /**
+     * @brief Take the oldest record out of the ring.
+     * @return true if a record was read
+     */
+    bool pop(LogRecord &record);
+
+    bool empty() const;
+};
+
+/**
+ * @brief Process wide logger. Records are written into a per-thread ring buffer and formatted
+ * and printed by a background thread, so logging never waits on I/O.
+ * Use through the LOG_* macros, which compile to nothing below GAME_ENGINE_LOG_LEVEL.
+ */
+class Logger
+{
+    std::chrono::steady_clock::time_point start_time;
+    mutex rings_m; ///< guards rings, only taken when a thread logs for the first time and by the drain thread
+    vector<shared_ptr<LogRing>> rings;
+    std::ostream *out;
+    std::atomic<bool> stopping;
+    std::thread drain_thread;
+
+    Logger();
+
+    LogRing &localRing();
+
+    /**
+     * @brief Read records from all rings until all are empty.
+     * @return true if anything was written
+     */
+    bool drain();
+
+    void write(const LogRecord &record);
+
+public:
+    static Logger &instance();
+
+    ~Logger();
+
+    /**
+     * @brief Queue a record. Called by the LOG_* macros.
+     * @param level one of the LOG_LEVEL_* values
+     * @param format string literal, `{}` is replaced by the next argument
+     * @param args at most LogRecord::max_args numbers or string literals
+     */
+    template <typename... Args>
+    void log(uint8_t level, const char *format, Args... args)
+    {
+        static_assert(sizeof...(Args) <= LogRecord::max_args, "Too many arguments for a log record");
+        LogRecord record;
+        record.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count();
+        record.format = format;
+        record.level = level;
+        record.arg_count = sizeof...(Args);
+        int i = 0;
+        ((record.args[i++] = LogArg(args)), ...);
+        (void)i;
+        localRing().push(record);
+    }
+
+    /**
+     * @brief Set the stream records are printed to. std::cout by default.
+     * @param out stream, must outlive the logger
+     */
+    void setOutput(std::ostream &out);
+
+    /**
+     * @brief Block until every record queued so far has been printed.
+     */
+    void flush();
+
+    /**
+     * @brief Total number of records dropped because a ring buffer was full.
+     */
+    uint64_t droppedCount();
+};
+
+#if GAME_ENGINE_LOG_LEVEL <= LOG_LEVEL_TRACE
+#define LOG_TRACE(...) Logger::instance().log(LOG_LEVEL_TRACE, __VA_ARGS__)
+#else
+#define LOG_TRACE(...) ((void)0)
+#endif
+
+#if GAME_ENGINE_LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) Logger::instance().log(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+
+#if GAME_ENGINE_LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) Logger::instance().log(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+
+#if GAME_ENGINE_LOG_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(...) Logger::instance().log(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) ((void)0)
+#endif
+
+#if GAME_ENGINE_LOG_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) Logger::instance().log(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
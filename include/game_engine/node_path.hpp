@@ -0,0 +1,79 @@
+/**
+ * @file node_path.hpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief Parsed paths of child names, remembering what they resolved to.
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include "std_includes.hpp"
+#include "atom.hpp"
+
+// defined here
+class NodePath;
+
+// extern
+class Object;
+
+/**
+ * @brief A path such as "Object2D/Sprite_1", split into interned names once. It remembers the last object it was
+ * resolved from and the nodes it went through, and resolves from the same object again without any lookup for as long
+ * as none of those nodes gained, lost or renamed a child. Keep paths which are resolved often, for example as static
+ * members, rather than building them from strings on every call. Lookups by string go through find() instead, which
+ * interns nothing.
+ * A NodePath must not be resolved from several threads at once.
+ */
+class NodePath
+{
+    vector<Atom> segments;
+    mutable vector<pair<const Object *, uint64_t>> visited; ///< nodes of the last resolution and their structure stamps
+    mutable Object *target = nullptr; ///< result of the last resolution, null if none is remembered
+
+public:
+    /**
+     * @brief Parse a path, interning its names so that they are ready once children are given them.
+     * @param path
+     */
+    explicit NodePath(std::string_view path);
+
+    explicit NodePath(const string &path) : NodePath(std::string_view(path))
+    {
+    }
+
+    explicit NodePath(const char *path) : NodePath(std::string_view(path))
+    {
+    }
+
+    const vector<Atom> &getSegments() const
+    {
+        return segments;
+    }
+
+    /**
+     * @brief The path as text, segments joined by '/'.
+     * @return string
+     */
+    string str() const;
+
+    /**
+     * @brief Find the object the path leads to, starting from the children of `root`.
+     * @param root
+     * @return shared_ptr<Object>
+     * @throws std::out_of_range if a segment names no child
+     */
+    shared_ptr<Object> resolve(Object *root) const;
+
+    /**
+     * @brief Find the object a path given as text leads to, starting from the children of `root`, without parsing it
+     * into a NodePath. Names are looked up among the interned ones, a name never interned is no child's.
+     * @param root
+     * @param path
+     * @return shared_ptr<Object>
+     * @throws std::out_of_range if a segment names no child
+     */
+    static shared_ptr<Object> find(Object *root, std::string_view path);
+};
@@ -86,13 +86,25 @@ public:
     }
 #endif
     template <typename T = Object2D>
-    inline shared_ptr<T> getChild(string path)
+    inline shared_ptr<T> getChild(const NodePath &path)
     {
         return root->getChild<T>(path);
     }
 
+    template <typename T = Object2D>
+    inline shared_ptr<T> getChild(std::string_view path)
+    {
+        return root->getChild<T>(path);
+    }
+
+    template <typename T>
+    inline shared_ptr<T> get(const NodePath &path)
+    {
+        return getChild<T>(path);
+    }
+
     template <typename T>
-    inline shared_ptr<T> get(string path)
+    inline shared_ptr<T> get(std::string_view path)
     {
         return getChild<T>(path);
     }
@@ -114,7 +126,7 @@ public:
      * @return shared_ptr<Object> the removed child
      * @throws std::out_of_range exception if no child has that name
      */
-    inline shared_ptr<Object> removeChild(string name)
+    inline shared_ptr<Object> removeChild(const string &name)
     {
         return root->removeChild(name);
     }
@@ -0,0 +1,141 @@
+/**
+ * @file object_handle.hpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief Generational handles to objects, resolved without touching reference counts.
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include "std_includes.hpp"
+
+// defined here
+class ObjectHandle;
+class ObjectTable;
+
+// extern
+class Object;
+
+/**
+ * @brief Every live Object has a slot here, found by index. A slot's generation changes when its object is destroyed,
+ * so that handles to it stop resolving before the slot is given to another object. Slots live in chunks which never
+ * move, up to 2^24 live objects. Each thread keeps the free slots it uses in a list of its own and only takes a lock
+ * to trade a batch of them with the shared list.
+ */
+class ObjectTable
+{
+    friend ObjectHandle;
+    friend Object;
+
+    struct Slot
+    {
+        Object *object = nullptr;
+        uint32_t generation = 1;
+    };
+
+    static const uint32_t chunk_bits = 12;
+    static const uint32_t chunk_size = 1 << chunk_bits;
+    static const uint32_t max_chunks = 1 << 12;
+
+    static Slot *chunks[max_chunks];
+
+    static Slot &slot(uint32_t index)
+    {
+        return chunks[index >> chunk_bits][index & (chunk_size - 1)];
+    }
+
+    /**
+     * @brief Add up to `count` free slots to a list, released ones first, otherwise never used ones.
+     * @throws std::runtime_error if there are none left at all
+     */
+    static void refill(vector<uint32_t> &into, size_t count);
+
+    /**
+     * @brief Give an object a slot.
+     * @throws std::runtime_error if all slots are taken
+     */
+    static ObjectHandle allocate(Object *obj);
+
+    /**
+     * @brief Free the slot of a handle, which from then on resolves to nothing.
+     */
+    static void release(ObjectHandle handle);
+};
+
+/**
+ * @brief Refers to an Object without owning it. Resolving is O(1), two loads and a compare, with no reference count
+ * traffic, and gives null once the object is destroyed. For use within the engine and by user code which knows the
+ * object is not being destroyed on another thread at the same time. lock() gives a shared_ptr where ownership is needed.
+ */
+class ObjectHandle
+{
+    friend ObjectTable;
+
+    uint32_t index = 0; ///< 0 for the null handle
+    uint32_t generation = 0;
+
+public:
+    /**
+     * @brief The null handle.
+     */
+    ObjectHandle() = default;
+
+    /**
+     * @brief The object, or null if it was destroyed.
+     * @return Object*
+     */
+    Object *get() const
+    {
+        if (index == 0)
+            return nullptr;
+        ObjectTable::Slot &slot = ObjectTable::slot(index);
+        return slot.generation == generation ? slot.object : nullptr;
+    }
+
+    /**
+     * @brief The object downcast to T, or null if it was destroyed or is not a T.
+     */
+    template <typename T>
+    T *as() const
+    {
+        return dynamic_cast<T *>(get());
+    }
+
+    /**
+     * @brief Shared ownership of the object, empty if it was destroyed.
+     * @return shared_ptr<Object>
+     */
+    shared_ptr<Object> lock() const;
+
+    explicit operator bool() const
+    {
+        return get() != nullptr;
+    }
+
+    bool operator==(const ObjectHandle &other) const
+    {
+        return index == other.index && generation == other.generation;
+    }
+
+    bool operator!=(const ObjectHandle &other) const
+    {
+        return !(*this == other);
+    }
+
+    size_t hash() const
+    {
+        return std::hash<uint64_t>()((uint64_t)generation << 32 | index);
+    }
+};
+
+template <>
+struct std::hash<ObjectHandle>
+{
+    size_t operator()(const ObjectHandle &handle) const
+    {
+        return handle.hash();
+    }
+};
@@ -14,16 +14,22 @@
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_mixer.h>
 
-#include <clock.h>   // clock/timer utility
 
 #include "std_includes.hpp"
 #include "colors.h" // #defined RGB_COLORs
 #include "vects.hpp" // Mathematical vectors
+#include "timer_wheel.hpp"
+#include "coroutine.hpp"
+#include "transform_system.hpp"
+#include "child_list.hpp"
+#include "node_path.hpp"
+#include "object_handle.hpp"
 
 // defined here
 class Object;
 class Object2D;
 class GraphicObject;
+struct TextureAtlas;
 class Texture;
 class Sprite;
 class AudioPlayer;
@@ -33,6 +39,7 @@ class HandlerI;
 // extern
 class GraphicSystem;
 class Engine;
+struct DrawCommand;
 
 /**
  * @brief Base class for all game objects. 
@@ -40,27 +47,169 @@ class Engine;
 class Object : public std::enable_shared_from_this<Object>
 {
     friend Engine;
+    friend Object2D; // passes transform changes down to its children
+    friend TransformSystem;
+    friend ChildList;
+    friend NodePath;
 
 protected:
-    weak_ptr<Object> parent_view;
-    map<string, shared_ptr<Object>> children_map; ///< allows named access to children
-    list<shared_ptr<Object>> children; ///< allows indexed access to children
-    string name;
+    ObjectHandle self_handle;
+    ObjectHandle parent_handle; ///< null if the object has no parent
+    Engine *engine_ptr = nullptr; ///< engine the object is registered in, cleared on unregistration and by the engine's destructor
+    unordered_map<Atom, shared_ptr<Object>> children_map; ///< allows named access to children
+    ChildList children; ///< allows indexed access to children
+    size_t child_entry = 0; ///< entry in the parent's child list
+    struct NameSuffixes
+    {
+        vector<Atom> names; ///< names[i - 1] is the desired name with suffix i, interned the first time it is given
+        vector<int> free;   ///< min-heap of the suffixes up to names.size() which no child holds
+    };
+    unordered_map<Atom, NameSuffixes> name_suffixes; ///< suffixes of each desired name already taken by a child
+    Atom suffix_base; ///< desired name whose suffix this object's name holds in its parent, empty if it holds none
+    int name_suffix = 0; ///< that suffix, returned to the parent when the object is removed
+    uint64_t structure_stamp; ///< replaced by a new, never used value whenever a child is added, removed or renamed
+    Atom name;
     function<void(Object *)> init_behavior;
     function<void(Object *, double)> loop_behavior;
     list<shared_ptr<HandlerI>> handlers;
+    bool thread_safe = false;
+    bool low_priority = false;
+    int loop_slot = -1; ///< index in the engine's loop list, -1 if the engine does not loop the object
+    int loop_list = 0;  ///< which of the engine's loop lists loop_slot refers to
+    int loop_interval = 1; ///< ticks between loops
+    int loop_group = 1; ///< loop interval of the group loop_slot refers to
+    double last_loop = -1; ///< simulated time of the last loop() of an object not looping every tick
+    shared_ptr<void> timer_owner; ///< lives while the object is registered, owns the object's timers
+    list<function<Behaviour(Object *)>> behaviour_factories;
+    BehaviourList behaviours; ///< running behaviours, destroyed on unregistration
+    bool behaviours_pending = false; ///< registered, and the behaviours not started yet
+    bool active = true; ///< see setActive()
+    bool engine_active = true; ///< whether the engine has last treated the object as active
+
+    /**
+     * @brief Start a behaviour, dropping finished ones.
+     */
+    void runBehaviour(const function<Behaviour(Object *)> &factory);
+
+    /**
+     * @brief Take a child out of the child list without touching its engine registration.
+     */
+    void detachChild(shared_ptr<Object> child);
+
+    /**
+     * @brief Called when the object is given a new parent, or none, and when the transform it inherits from its parent changes.
+     * @param reparented the parent itself changed
+     */
+    virtual void parentChanged(bool /*reparented*/)
+    {
+    }
+
+    /**
+     * @brief Make a new object of the same type, with the same state but no parent, children, handlers or registration.
+     * Every class meant to be cloned overrides it, usually as make_shared of its copy constructor.
+     * @return shared_ptr<Object>
+     */
+    virtual shared_ptr<Object> cloneSelf() const;
+
+    /**
+     * @brief Put back the state cloneSelf() copies, from the object this one was cloned from.
+     * @param prototype of the same type
+     */
+    virtual void restoreSelf(Object &/*prototype*/)
+    {
+    }
 public:
-    string desiredName;
-    weak_ptr<Engine> engine_view;
+    Atom desiredName;
 
-    Object(string desiredName = "Object");
+    Object(Atom desiredName = "Object");
+
+    /**
+     * @brief Copy the configuration of an object: its desired name, behaviours and loop settings.
+     * Not its place in the tree, handlers, registration or timers.
+     */
+    Object(const Object &other);
+
+    Object &operator=(const Object &) = delete;
+
+    virtual ~Object();
 
     virtual void init();
 
     virtual void loop(double delta);
 
+    /**
+     * @brief Declare that loop() only touches this object's own state, so the engine may run it
+     * on a worker thread, concurrently with other objects' loops.
+     * @param thread_safe
+     */
+    void setThreadSafe(bool thread_safe);
+
+    bool isThreadSafe();
+
+    /**
+     * @brief Declare that the object's loop() may run less often when the engine is overloaded.
+     * It is then given the whole time since its last loop as delta.
+     * @param low_priority
+     */
+    void setLowPriority(bool low_priority);
+
+    bool isLowPriority();
+
+    /**
+     * @brief Loop once every `ticks` ticks instead of every tick, such as 6 for AI running at 10 Hz with 60 ticks per second.
+     * loop() is then given the whole time since its last loop as delta. Objects with the same interval take turns, so
+     * only a share of them loop on any tick.
+     * @param ticks
+     */
+    void setLoopInterval(int ticks);
+
+    int getLoopInterval();
+
     shared_ptr<Engine> getEngine();
 
+    /**
+     * @brief A handle which resolves to this object until it is destroyed.
+     * @return ObjectHandle
+     */
+    ObjectHandle getHandle() const
+    {
+        return self_handle;
+    }
+
+    /**
+     * @brief Handle of the parent, null if the object has none.
+     * @return ObjectHandle
+     */
+    ObjectHandle getParentHandle() const
+    {
+        return parent_handle;
+    }
+
+    /**
+     * @brief Call `callback` once, after `seconds` of simulated time. The timer is dropped if the object
+     * is unregistered or destroyed first. Not callable from parallel loops.
+     * @param seconds
+     * @param callback
+     * @return TimerId
+     * @throws std::runtime_error if the object is not registered in an engine
+     */
+    TimerId after(double seconds, function<void()> callback);
+
+    /**
+     * @brief Call `callback` every `period` seconds of simulated time, for as long as the object is registered.
+     * @param period
+     * @param callback
+     * @return TimerId
+     * @throws std::runtime_error if the object is not registered in an engine
+     */
+    TimerId every(double period, function<void()> callback);
+
+    /**
+     * @brief Stop a timer set by after() or every().
+     * @return true if the timer was pending
+     */
+    bool cancelTimer(TimerId id);
+
     /**
      * @brief Get the object's parent. If orphan, returns an empty shared_ptr.
      * @return shared_ptr<Object> the object's parent
@@ -71,9 +220,9 @@ public:
      * @brief The name the node is given by the parrent. May be appended by an index if another child already has that name.
      * @return string 
      */
-    string getDesiredName();
+    const string &getDesiredName();
 
-    string getName();
+    const string &getName();
 
     /**
      * @brief Attach a handler to the object, and register it in the engine if it exists.
@@ -85,19 +234,31 @@ public:
     void dettachHandler(shared_ptr<HandlerI> handle);
     
     /**
-     * @brief Returns a deep copy of the object, its children, etc. The clone is registered in the systems the original is registered in.
+     * @brief Returns a deep copy of the object and its descendants, unregistered. Children keep their names.
      * @return shared_ptr<Object> 
+     * @throws std::runtime_error if the object or a descendant is of a class which does not override cloneSelf()
+     */
+    shared_ptr<Object> clone() const;
+
+    /**
+     * @brief Put back the state of the object and its descendants from the object they were cloned from,
+     * matching children by index.
+     * @param prototype
      */
-    /*virtual shared_ptr<Object> clone()
+    void resetTo(Object &prototype);
+
+    /**
+     * @brief Deactivate or reactivate the object and its descendants. Inactive objects stay registered, keeping their
+     * physics bodies and graphics, but are not looped, drawn or simulated, their handlers get no events,
+     * and their timers and behaviours are dropped. Reactivated objects start their behaviours again.
+     * @param active
+     */
+    void setActive(bool active);
+
+    bool isActive() const
     {
-        shared_ptr<Object> c = make_shared<Object>(this);
-        
-        for(auto child : children)
-        {
-            c->addChild(child->clone());
-        }
-        return c;
-    }*/
+        return active;
+    }
 
     /**
      * @brief A callable which is called in the object's loop
@@ -111,8 +272,18 @@ public:
      */
     void attachLoopBehaviour(function<void(Object *, double)> behavior);
 
+    /**
+     * @brief A coroutine which runs while the object is registered, see Behaviour.
+     * Started on the first tick the object is registered for, and again whenever it is registered anew.
+     * @param behaviour callable returning the coroutine, for example a lambda `[](Object *self) -> Behaviour { ... }`
+     */
+    void attachBehaviour(function<Behaviour(Object *)> behaviour);
+
     /**
      * @brief Add child to the object. Child is appended to the back of the child list.
+     * If another child has its desired name, it is named with the smallest free suffix, such as Sprite_1, which is
+     * free again once that child is removed.
+     * If the child has a parent already, it is moved, keeping its engine registration if it stays in the same engine.
      * @param child child object
      */
     void addChild(shared_ptr<Object> child);
@@ -186,21 +357,35 @@ public:
     }
 #endif
     /**
-     * @brief Get child by name.
+     * @brief Get a descendant by path, names separated by '/'. A NodePath kept by the caller remembers the result.
      * @param path 
      * @return shared_ptr<Object>
      * @throws std::out_of_range 
      */
-    shared_ptr<Object> getChild(string path);
+    shared_ptr<Object> getChild(const NodePath &path);
 
     /**
-     * @brief Get child by name.
+     * @brief Get a descendant by path given as text, see NodePath::find().
      * @param path 
      * @return shared_ptr<Object>
      * @throws std::out_of_range 
      */
+    shared_ptr<Object> getChild(std::string_view path);
+
+    /**
+     * @brief Get a descendant by path, names separated by '/'.
+     * @param path 
+     * @return shared_ptr<Object>
+     * @throws std::out_of_range 
+     */
+    template <typename T>
+    inline shared_ptr<T> getChild(const NodePath &path)
+    {
+        return dynamic_pointer_cast<T>(getChild(path));
+    }
+
     template <typename T>
-    inline shared_ptr<T> getChild(string path)
+    inline shared_ptr<T> getChild(std::string_view path)
     {
         return dynamic_pointer_cast<T>(getChild(path));
     }
@@ -208,17 +393,23 @@ public:
     /**
      * @brief Short alias of getChild
      * @tparam T
-     * @param indices
+     * @param path
      * @return shared_ptr<T>
      */
     template <typename T = Object>
-    inline shared_ptr<T> get(string path)
+    inline shared_ptr<T> get(const NodePath &path)
+    {
+        return getChild<T>(path);
+    }
+
+    template <typename T = Object>
+    inline shared_ptr<T> get(std::string_view path)
     {
         return getChild<T>(path);
     }
 
     /**
-     * @brief Remove child by index.
+     * @brief Remove child by index. The child is unregistered from the engine.
      * @param index position of the child in the child list
      * @return shared_ptr<Object> the removed child
      * @throws std::out_of_range exception if the child index is out of range
@@ -226,46 +417,103 @@ public:
     shared_ptr<Object> removeChild(int index);
 
     /**
-     * @brief Remove child by name.
+     * @brief Remove child by name. The child is unregistered from the engine.
      * @param name name of the child to be removed
      * @return shared_ptr<Object> the removed child
      * @throws std::out_of_range exception if no child has that name
      */
-    shared_ptr<Object> removeChild(string name);
+    shared_ptr<Object> removeChild(const string &name);
 
 };
 
 /**
  * @brief Base class for objects supporting 2D position. Position is relative to its parent.
+ * The world transform is cached, and recomputed on the first read after the object or one of its ancestors moved.
+ * A read may thus update the caches of its ancestors: parallel loops should only read the transforms of objects
+ * which no other loop moves during the tick.
  */
 class Object2D : public Object
 {
+    friend TransformSystem;
+
+    TransformSystem *transform_system = nullptr; ///< system of the engine the object is registered in, which has a copy of its transform
+    int transform_slot = -1;
+    Object2D *parent2d = nullptr; ///< the parent, if it is an Object2D. Kept by parentChanged(), the parent outlives the link.
+    bool transform_dirty = true;  ///< if set, the descendants are dirty as well
+    Vect2f world_position;
+    Vect2f world_rotation = {1, 0};
+    float world_scale = 1;
+
+    /**
+     * @brief Drop the cached world transform of the object and its descendants.
+     */
+    void markDirty();
+
+    void updateTransform();
+
+    /**
+     * @brief Write the local transform through to the transform system and drop the cached world transforms.
+     */
+    void transformChanged();
+
+protected:
+    Vect2f offset;            ///< offset relative to parent, or global position if root
+    float scale = 1;          ///< factor by which to scale the object
+    Vect2f rotation = {1, 0}; ///< rotation relative to the parent, as a unit vector
+
+    void parentChanged(bool reparented) override;
+
+    shared_ptr<Object> cloneSelf() const override;
+
+    void restoreSelf(Object &prototype) override;
+
 public:
-    Vect2f offset;           ///< offset relative to parent, or global position if root
-    const Vect2f getPosition(); ///< actual position, result of parent.position + offset 
-    void setPosition(Vect2f pos) ///< set offset such that getPosition() returns pos
+    const Vect2f getPosition(); ///< actual position, result of parent.position + offset
+    void setPosition(Vect2f pos); ///< set offset such that getPosition() returns pos
+
+    Vect2f getOffset()
     {
-        offset -= getPosition() - pos;
+        return offset;
     }
 
+    void setOffset(Vect2f offset);
+
     Vect2f base_size;    ///< the 'original' size of the object, can be used to remove scaling
-    float scale = 1;     ///< factor by which to scale the object
-    const Vect2f getSize(); ///< actual size of the object, scale effected by parrent
+    const Vect2f getSize(); ///< actual size of the object, base_size scaled by the object and its ancestors
 
-    Vect2f rotation = {1, 0}; ///< rotation relative to the parent, as a unit vector
-    const Vect2f getOrientation();
+    float getScale()
+    {
+        return scale;
+    }
+
+    void setScale(float scale);
+
+    const Vect2f getOrientation(); ///< actual rotation, as a unit vector
+
+    Vect2f getRotation()
+    {
+        return rotation;
+    }
+
+    /**
+     * @brief Set the rotation relative to the parent.
+     * @param rotation unit vector
+     */
+    void setRotation(Vect2f rotation);
 
     /**
      * @brief Construct a new Object2D
      */
-    Object2D(string desiredName = "Object2D");
+    Object2D(Atom desiredName = "Object2D");
 
     /**
      * @brief Construct a new Object2D
      * @param offset
      * @param base_size
      */
-    Object2D(Vect2f offset, Vect2f base_size, string desiredName = "Object2D");
+    Object2D(Vect2f offset, Vect2f base_size, Atom desiredName = "Object2D");
+
+    Object2D(const Object2D &other);
 };
 
 /**
@@ -286,6 +534,8 @@ public:                                  // TODO: protected later?
     };
     Color color = RED;
     int z = 0; ///< also called z, sets draw z/draw order for objects occupying the same space.
+    Vect2f previous_position; ///< position at the start of the last fixed step, used for interpolation
+    bool has_previous = false; ///< set once the graphic system has taken a snapshot of the object
 public:
     /**
      * @brief Construct a new GraphicObject
@@ -298,7 +548,9 @@ public:
      * @param offset
      * @param base_size
      */
-    GraphicObject(Vect2f offset, Vect2f base_size, string desiredName = "GraphicObject");
+    GraphicObject(Vect2f offset, Vect2f base_size, Atom desiredName = "GraphicObject");
+
+    GraphicObject(const GraphicObject &other);
 
     /**
      * @brief Set the draw Height of the object. When objects are occupying the same space,
@@ -310,7 +562,42 @@ public:
 
     static void setDrawColor(SDL_Renderer *render, Color c);
 
+    /**
+     * @brief Position to draw the object at. When the engine runs with a fixed step, this is the
+     * position interpolated between the last two simulation steps, otherwise it is getPosition().
+     * @return Vect2f
+     */
+    Vect2f getDrawPosition();
+
     virtual void draw() = 0;
+
+    /**
+     * @brief Append the object's draw commands to a frame recorded for later submission, used by the pipelined engine mode.
+     * Like draw(), every graphic object has to implement it, so that none goes missing in that mode.
+     * @param list
+     */
+    virtual void record(vector<DrawCommand> &list) = 0;
+
+protected:
+    void restoreSelf(Object &prototype) override;
+};
+
+/**
+ * @brief Decoded image data and the sprites defined on it. Can be shared by Textures in different engines,
+ * read only once the sprites are defined. The SDL_Texture belongs to the renderer it was made with,
+ * so atlases loaded headless, which have none, are the ones to share across engines.
+ */
+struct TextureAtlas
+{
+    SDL_Texture *texture = nullptr;
+    Vect2i size;
+    map<string, SDL_Rect> sprites; ///< source regions by sprite name
+
+    TextureAtlas() = default;
+    TextureAtlas(const TextureAtlas &) = delete;
+    TextureAtlas &operator=(const TextureAtlas &) = delete;
+
+    ~TextureAtlas();
 };
 
 /**
@@ -318,32 +605,45 @@ public:
  */
 class Texture : public Object
 {
-    SDL_Texture *texture;
-    Vect2i size;
-    map<string, Sprite> sprites;
+    shared_ptr<TextureAtlas> atlas;
 public:
 
     /**
      * @brief Construct a new Texture object
      * @param desiredName
      */
-    Texture(string desiredName = "Texture");
+    Texture(Atom desiredName = "Texture");
+
+    /**
+     * @brief Construct a Texture using existing atlas data, without loading or decoding anything.
+     * @param atlas
+     * @param desiredName
+     */
+    Texture(shared_ptr<TextureAtlas> atlas, Atom desiredName = "Texture");
     
     /**
      * @brief Set the internal SDL_Texture
-     * @param render SDL_Renderer
+     * @param render SDL_Renderer. If null, the image is only decoded to read its size and no SDL_Texture is created.
      * @param filepath File from which to load the image. Relative path is relative to executable location.
      */
     void setTexture(SDL_Renderer *render, string filepath);
 
+    /**
+     * @brief The texture's data and sprite definitions, to share with Textures of other engines.
+     * @return shared_ptr<TextureAtlas>
+     */
+    shared_ptr<TextureAtlas> getAtlas();
+
     /**
      * @brief Get the internal SDL_Texture, do not use unless you know what you're doing
-     * @return SDL_Texture* pointer to the internal SDL_Texture, guaranteed to be valid for the lifetime of the `Texture` object
+     * @return SDL_Texture* pointer to the internal SDL_Texture, guaranteed to be valid for the lifetime of the `Texture` object.
+     * Null if the texture was loaded without a renderer.
      */
     SDL_Texture *getTexture();
 
     /**
      * @brief Adds a sprite definition to the atlas. This can be used to then produce that sprite.
+     * Not to be called while other threads use the atlas.
      */
     void defineSprite(Vect4i src_region, string name);
 
@@ -355,11 +655,8 @@ public:
      */
     shared_ptr<Sprite> buildSprite(string name);
 
-    /**
-     * @brief Destroy the Texture object
-     *
-     */
-    ~Texture();
+protected:
+    shared_ptr<Object> cloneSelf() const override;
 };
 
 /**
@@ -367,8 +664,8 @@ public:
  */
 class Sprite : public GraphicObject
 {
-    shared_ptr<Texture> texture; ///< Texture for the sprite to use
-    SDL_Rect src_region;         ///< The region of the underlying texture this sprite uses
+    shared_ptr<TextureAtlas> atlas; ///< Texture data for the sprite to use
+    SDL_Rect src_region;            ///< The region of the underlying texture this sprite uses
 public:
 
     /**
@@ -378,7 +675,16 @@ public:
      * @param offset offset of the sprite
      * @param size size of the sprite
      */
-    Sprite(shared_ptr<Texture> texture, Vect4i src_region, Vect2f offset, Vect2f size, string desiredName = "Sprite");
+    Sprite(shared_ptr<Texture> texture, Vect4i src_region, Vect2f offset, Vect2f size, Atom desiredName = "Sprite");
+
+    /**
+     * @brief Construct a new Sprite object straight from atlas data
+     * @param atlas
+     * @param src_region the region from the texture to be used by the sprite
+     * @param offset offset of the sprite
+     * @param size size of the sprite
+     */
+    Sprite(shared_ptr<TextureAtlas> atlas, SDL_Rect src_region, Vect2f offset, Vect2f size, Atom desiredName = "Sprite");
 
     /**
      * @brief Scale size to have a width of 'x'
@@ -394,6 +700,16 @@ public:
      * @brief Draw the sprite
      */
     void draw() override;
+
+    void record(vector<DrawCommand> &list) override;
+
+protected:
+    shared_ptr<Object> cloneSelf() const override;
+
+    void restoreSelf(Object &prototype) override;
+
+private:
+    DrawCommand makeCommand();
 };
 
 /**
@@ -401,11 +717,33 @@ public:
  */
 class AudioPlayer : public Object
 {
+    string file;
     Mix_Chunk *sound;
-    int volume;
+    int volume = MIX_MAX_VOLUME;
+
+protected:
+    shared_ptr<Object> cloneSelf() const override
+    {
+        return make_shared<AudioPlayer>(*this);
+    }
+
 public:
     bool loop = false;
-    AudioPlayer(string file, string desiredName = "Sprite") : Object(desiredName)
+    AudioPlayer(string file, Atom desiredName = "Sprite") : Object(desiredName), file(file)
+    {
+        load();
+    }
+
+    /**
+     * @brief Load the same file again, the copy has a sound of its own.
+     */
+    AudioPlayer(const AudioPlayer &other) : Object(other), file(other.file), volume(other.volume), loop(other.loop)
+    {
+        load();
+        Mix_VolumeChunk(sound, volume);
+    }
+
+    void load()
     {
         sound = Mix_LoadWAV(file.c_str());
         if (!sound)
@@ -437,6 +775,7 @@ public:
         if(volume < 0)
             volume = 0;
         
+        this->volume = volume;
         Mix_VolumeChunk(sound, volume);
     }
 
@@ -448,9 +787,6 @@ public:
 
 class EngineController : public Object
 {
-    Clock timeout;
 public:
     void init() override;
-
-    void loop(double delta) override;
 };
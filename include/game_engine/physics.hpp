@@ -2,6 +2,7 @@
 #include <box2d/box2d.h>
 
 #include "objects.hpp"
+#include "profiler.hpp"
 
 const float pixels_per_meter = 1024;
 /**
@@ -34,6 +35,33 @@ public:
         fixt.shape = &shape;
         fixt.density = 1;
     }
+
+    /**
+     * @brief Copy the body definition. The copy gets a body of its own once registered.
+     */
+    PhysicsObject(const PhysicsObject &other) : Object2D(other), def(other.def), shape(other.shape), fixt(other.fixt)
+    {
+        motion_check = other.motion_check;
+        fixt.shape = &shape;
+    }
+
+protected:
+    shared_ptr<Object> cloneSelf() const override
+    {
+        return make_shared<PhysicsObject>(*this);
+    }
+
+    /**
+     * @brief Also stops the body, which is moved to the restored position by the next physics step.
+     */
+    void restoreSelf(Object &prototype) override
+    {
+        Object2D::restoreSelf(prototype);
+        if (body == nullptr)
+            return;
+        body->SetLinearVelocity({0, 0});
+        body->SetAngularVelocity(0);
+    }
 };
 
 /**
@@ -45,10 +73,22 @@ public:
     b2World world;
     // box2d works with meters, as such the display needs to be ~1m in size for the physics to work well.
     set<shared_ptr<PhysicsObject>> bucket;
+    TransformSystem *transforms = nullptr; ///< world transforms of the objects, set by the engine
     World(Vect2f gravity) : world({gravity.x / pixels_per_meter, gravity.y / pixels_per_meter})
     {
     }
 
+    /**
+     * @brief Whether a position read back differs from the one written by no more than rounding. The transform system
+     * and Object2D compute world positions separately, and may round differently, for example with contracted
+     * multiply-adds.
+     */
+    static bool unmoved(Vect2f pos, Vect2f written)
+    {
+        auto close = [](float a, float b) { return std::abs(a - b) <= 1e-5f * std::fmax(1.0f, std::abs(b)); };
+        return close(pos.x, written.x) && close(pos.y, written.y);
+    }
+
     void registerObj(shared_ptr<PhysicsObject> obj)
     {
         obj->body = world.CreateBody(&obj->def);
@@ -63,19 +103,30 @@ public:
         bucket.erase(obj);
     }
 
-    void update()
+    /**
+     * @brief Sync moved objects into box2d, step the simulation and write the results back.
+     * @param time_step seconds simulated by this step
+     */
+    void update(float time_step = 1.0f / 60)
     {
+        PROFILE_ZONE("World::update");
+        if(transforms)
+            transforms->update(); // picks up what moved since, the previous step included
         for(auto object : bucket)
         {
-            Vect2f pos = object->getPosition();
-            if(pos == object->motion_check)
+            if(!object->isActive())
+                continue; // disabled in box2d, left where it was
+            Vect2f pos = transforms ? transforms->position(object.get()) : object->getPosition();
+            if(unmoved(pos, object->motion_check))
                 continue;
-            Vect2f game_pos = object->getPosition() / pixels_per_meter;
+            Vect2f game_pos = pos / pixels_per_meter;
             object->body->SetTransform({game_pos.x, game_pos.y}, 0);
         }
-        world.Step(1.0f/60, 6, 2);
+        world.Step(time_step, 6, 2);
         for(auto object : bucket)
         {
+            if(!object->isActive())
+                continue;
             b2Transform world_pos = object->body->GetTransform();
             object->setPosition({world_pos.p.x * pixels_per_meter, world_pos.p.y * pixels_per_meter});
             object->motion_check = object->getPosition();
@@ -0,0 +1,77 @@
+/**
+ * @file prefab.hpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief Subtrees instantiated from a template, and optionally recycled.
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include "std_includes.hpp"
+
+// defined here
+class Prefab;
+
+// extern
+class Object;
+
+/**
+ * @brief Instantiates copies of a prototype subtree, see Object::clone(). The prototype is not registered anywhere.
+ * With a pool capacity, released instances are deactivated and kept, still registered along with their bodies and
+ * graphics, and the next instantiate() resets one to the prototype and reactivates it instead of cloning.
+ * Not thread safe.
+ */
+class Prefab
+{
+    shared_ptr<Object> prototype;
+    vector<shared_ptr<Object>> pool; ///< released instances, inactive
+    size_t capacity;
+
+public:
+    /**
+     * @brief Construct a new Prefab
+     * @param prototype the subtree to copy, which should not be changed once instances are made
+     * @param capacity how many released instances to keep, 0 to keep none
+     */
+    Prefab(shared_ptr<Object> prototype, size_t capacity = 0);
+
+    /**
+     * @brief A recycled instance if one was released, otherwise a new clone.
+     * A recycled instance is where it was released, registered, and active again. A clone has no parent.
+     * @return shared_ptr<Object>
+     */
+    shared_ptr<Object> instantiate();
+
+    /**
+     * @brief instantiate(), downcast to the template type.
+     * @tparam T
+     * @return shared_ptr<T>
+     */
+    template <typename T>
+    shared_ptr<T> instantiate()
+    {
+        return static_pointer_cast<T>(instantiate());
+    }
+
+    /**
+     * @brief Despawn an instance: pool it if there is room, otherwise remove it from its parent.
+     * @param instance
+     */
+    void release(shared_ptr<Object> instance);
+
+    shared_ptr<Object> getPrototype()
+    {
+        return prototype;
+    }
+
+    /**
+     * @brief Released instances waiting to be recycled.
+     */
+    size_t pooled()
+    {
+        return pool.size();
+    }
+};
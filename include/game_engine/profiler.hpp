@@ -0,0 +1,133 @@
+/**
+ * @file profiler.hpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief Scoped zone profiler, exports chrome://tracing / Perfetto JSON traces.
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include "std_includes.hpp"
+
+// defined here
+struct ProfileEvent;
+class Profiler;
+class ProfileZone;
+
+/**
+ * @brief A finished zone.
+ */
+struct ProfileEvent
+{
+    const char *name; ///< zone name, must be a literal
+    uint64_t start;   ///< nanoseconds since the profiler was created
+    uint64_t end;
+    unsigned long frame;
+};
+
+/**
+ * @brief Process wide profiler. Zones are only recorded while a capture is running,
+ * so an idle profiler costs one branch per zone. Compiled out unless GAME_ENGINE_PROFILER is defined.
+ */
+class Profiler
+{
+    struct ThreadBuffer
+    {
+        mutex m; ///< uncontended except while a trace is written
+        vector<ProfileEvent> events;
+        uint32_t thread_id;
+    };
+
+    std::chrono::steady_clock::time_point start_time;
+    mutex buffers_m; ///< guards buffers, taken when a thread records its first zone and when writing the trace
+    vector<shared_ptr<ThreadBuffer>> buffers;
+    std::atomic<bool> capturing;
+    std::atomic<unsigned long> frame{0};
+    unsigned long first_frame = 0;
+    unsigned long last_frame = 0;
+    uint64_t frame_start = 0;
+    string path;
+
+    Profiler();
+
+    ThreadBuffer &localBuffer();
+
+    void writeTrace();
+
+public:
+    static Profiler &instance();
+
+    /**
+     * @brief Record the frames in [first_frame, last_frame] and write them to a trace file once the last one ends.
+     * Frames are counted by frameMark(), starting at 0.
+     * @param first_frame first frame to record
+     * @param last_frame last frame to record
+     * @param path file to write the JSON trace to, open it with chrome://tracing or ui.perfetto.dev
+     */
+    void capture(unsigned long first_frame, unsigned long last_frame, string path);
+
+    /**
+     * @brief Mark the end of a frame. Called once per frame by the engine.
+     */
+    void frameMark();
+
+    inline bool isCapturing()
+    {
+        return capturing.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Nanoseconds since the profiler was created.
+     */
+    inline uint64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count();
+    }
+
+    void record(const char *name, uint64_t start, uint64_t end);
+};
+
+/**
+ * @brief RAII zone, records the time between its construction and destruction. Use through PROFILE_ZONE.
+ */
+class ProfileZone
+{
+    const char *name;
+    uint64_t start;
+    bool active;
+
+public:
+    ProfileZone(const char *name) : name(name)
+    {
+        active = Profiler::instance().isCapturing();
+        if (active)
+            start = Profiler::instance().now();
+    }
+
+    ~ProfileZone()
+    {
+        if (active)
+            Profiler::instance().record(name, start, Profiler::instance().now());
+    }
+};
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef GAME_ENGINE_PROFILER
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#define PROFILE_FRAME() Profiler::instance().frameMark()
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+#endif
+
+// zones around every Object::loop and GraphicObject::draw call, very verbose
+#if defined(GAME_ENGINE_PROFILER) && defined(GAME_ENGINE_PROFILE_OBJECTS)
+#define PROFILE_OBJECT_ZONE(name) PROFILE_ZONE(name)
+#else
+#define PROFILE_OBJECT_ZONE(name) ((void)0)
+#endif
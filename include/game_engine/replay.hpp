@@ -0,0 +1,142 @@
+/**
+ * @file replay.hpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief Recording of input events and the RNG seed, and playing them back tick for tick.
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <fstream>
+
+#include "std_includes.hpp"
+
+// defined here
+class ReplayWriter;
+class ReplayReader;
+
+/**
+ * File layout, all integers little endian:
+ * header: "GERP", u16 version, u32 seed, f64 tick rate
+ * records: varint ticks since the previous record, u8 kind, payload
+ *   KEY:   u8 down, u8 repeat, varint scancode, zigzag varint keycode, u16 modifiers
+ *   MOUSE: u8 down, u8 button, u8 clicks, zigzag varint x, zigzag varint y
+ *   END:   no payload, the record's tick is the length of the recording
+ *   PAUSED: no payload, the record's tick ran with zero length while the engine's clock was paused (version 2)
+ */
+namespace replay_format
+{
+    const char magic[4] = {'G', 'E', 'R', 'P'};
+    const uint16_t version = 2; // version 1 files, which have no PAUSED records, are read as well
+
+    enum Kind : uint8_t
+    {
+        END = 0,
+        KEY = 1,
+        MOUSE = 2,
+        PAUSED = 3
+    };
+}
+
+/**
+ * @brief Writes the hardware events of a session, by the tick they were dispatched on.
+ */
+class ReplayWriter
+{
+    std::ofstream file;
+    unsigned long start_tick;
+    unsigned long last_tick = 0; ///< relative to start_tick
+    bool finished = false;
+
+    void writeVarint(uint64_t value);
+    void writeSigned(int64_t value);
+    void writeByte(uint8_t value);
+    void writeRecord(unsigned long tick, replay_format::Kind kind);
+
+public:
+    /**
+     * @brief Create the file and write its header.
+     * @param path
+     * @param seed seed of the engine's RNG at the start of the recording
+     * @param tick_rate fixed steps per second the recording is made at
+     * @param start_tick engine tick the recording starts at, ticks are stored relative to it
+     * @throws std::runtime_error if the file can not be created
+     */
+    ReplayWriter(string path, uint32_t seed, double tick_rate, unsigned long start_tick);
+
+    /**
+     * @brief Writes the end record, if finish() was not called.
+     */
+    ~ReplayWriter();
+
+    /**
+     * @brief Record an event. Events which HardwareEventBuilder does not build are ignored.
+     * @param tick engine tick the event is dispatched on
+     * @param e
+     */
+    void write(unsigned long tick, const SDL_Event &e);
+
+    /**
+     * @brief Record that a tick runs with zero length, the clock being paused.
+     * @param tick engine tick
+     */
+    void paused(unsigned long tick);
+
+    /**
+     * @brief Write the end record and close the file.
+     * @param tick engine tick the recording stops at
+     */
+    void finish(unsigned long tick);
+};
+
+/**
+ * @brief Reads a recording back, handing out its events on the ticks they were recorded on.
+ */
+class ReplayReader
+{
+    vector<pair<unsigned long, SDL_Event>> events; ///< decoded events, by tick relative to start_tick
+    size_t next_event = 0;
+    vector<unsigned long> paused_ticks; ///< ticks of zero length, relative to start_tick
+    size_t next_paused = 0;
+    unsigned long start_tick;
+    unsigned long length = 0;
+
+public:
+    uint32_t seed;
+    double tick_rate;
+
+    /**
+     * @brief Load and decode a recording. A recording cut short, by a crash for example, plays up to its last event.
+     * @param path
+     * @param start_tick engine tick the playback starts at
+     * @throws std::runtime_error if the file can not be read or is not a recording
+     */
+    ReplayReader(string path, unsigned long start_tick);
+
+    /**
+     * @brief Ticks the recording lasts.
+     */
+    unsigned long getLength()
+    {
+        return length;
+    }
+
+    /**
+     * @brief Take the next event recorded for the given tick.
+     * @param tick engine tick
+     * @param e set to the event
+     * @return false once the tick has no events left
+     */
+    bool next(unsigned long tick, SDL_Event &e);
+
+    /**
+     * @brief Whether the tick was run with zero length, the clock being paused. Ticks are to be asked about in order.
+     * @param tick engine tick
+     */
+    bool paused(unsigned long tick);
+};
@@ -0,0 +1,93 @@
+/**
+ * @file stats.hpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief Runtime statistics of an engine: what it holds and how long its recent frames took.
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include "std_includes.hpp"
+
+// defined here
+struct FrameHistogram;
+class RollingHistogram;
+struct EngineStats;
+
+/**
+ * @brief Distribution of one subsystem's time over recent frames, in milliseconds.
+ * Bucket i counts the frames under bound(i), and over bound(i - 1).
+ */
+struct FrameHistogram
+{
+    static const int buckets = 12;
+    unsigned long samples = 0; ///< frames in the window
+    double mean = 0;
+    double max = 0;
+    double last = 0;
+    uint32_t counts[buckets] = {};
+
+    /**
+     * @brief Upper bound of a bucket in milliseconds, doubling from 0.25. The last bucket is unbounded.
+     */
+    static double bound(int bucket)
+    {
+        return bucket < buckets - 1 ? 0.25 * (1 << bucket) : INFINITY;
+    }
+};
+
+/**
+ * @brief Keeps the last `window` samples and their histogram. Adding a sample is O(1).
+ */
+class RollingHistogram
+{
+public:
+    static const size_t window = 256;
+
+private:
+    float samples[window];
+    size_t next = 0;
+    size_t count = 0;
+    double sum = 0;
+    uint32_t counts[FrameHistogram::buckets] = {};
+
+    static int bucketOf(double ms);
+
+public:
+    /**
+     * @brief Add a sample, dropping the oldest once the window is full.
+     * @param ms
+     */
+    void add(double ms);
+
+    FrameHistogram summary() const;
+};
+
+/**
+ * @brief Snapshot of an engine's counters and frame timings, see Engine::getStats().
+ */
+struct EngineStats
+{
+    unsigned long ticks = 0;
+    double sim_time = 0;           ///< simulated seconds
+    size_t objects = 0;            ///< registered objects
+    size_t looping_objects = 0;    ///< objects looped by the engine
+    size_t handlers = 0;           ///< event handlers
+    size_t graphic_objects = 0;
+    size_t physics_bodies = 0;
+    size_t pending_timers = 0;
+    FrameHistogram input;      ///< taking and recording events
+    FrameHistogram simulation; ///< ticks, physics excluded
+    FrameHistogram physics;
+    FrameHistogram render;     ///< drawing and presenting, or recording the draw list when pipelined
+    FrameHistogram frame;      ///< wall time between frames
+
+    /**
+     * @brief One JSON object, histograms as {"samples", "mean", "max", "last", "bounds", "counts"}. Times are in milliseconds.
+     * @return string
+     */
+    string toJson() const;
+};
@@ -8,20 +8,32 @@
 #include <map>
 #include <set>
 #include <unordered_set> // hash table
+#include <unordered_map>
 #include <utility>
 
 #include <functional>
 #include <iostream> // cout
 #include <random>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <chrono>
+#include <atomic>
 #if defined(__MINGW32__) || defined(__MINGW64__)
 #include "mingw-threads/mingw.mutex.h"
+#include "mingw-threads/mingw.thread.h"
+#include "mingw-threads/mingw.condition_variable.h"
+#include "mingw-threads/mingw.shared_mutex.h"
 #else
 #include <mutex>
-#include <atomic>
+#include <shared_mutex>
+#include <thread>
+#include <condition_variable>
 #endif
 // smart pointer relevant
 using std::shared_ptr;
 using std::weak_ptr;
+using std::unique_ptr;
 /// \cond
 using std::enable_shared_from_this; // allows safe taking of shared_ptr<>(this) instance
 /// \endcond
@@ -39,6 +51,7 @@ using std::queue;
 using std::map;
 using std::set;
 using std::unordered_set;
+using std::unordered_map;
 
 using std::function;
 using std::pair;
@@ -0,0 +1,113 @@
+/**
+ * @file timer_wheel.hpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief Hierarchical timer wheel, for callbacks which fire after a delay or periodically.
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include "std_includes.hpp"
+
+// defined here
+class TimerWheel;
+
+/**
+ * @brief Identifies a scheduled timer. 0 is never a valid id.
+ */
+typedef uint64_t TimerId;
+
+/**
+ * @brief Four levels of 256 slots, each level counting in units of a full turn of the level below.
+ * Scheduling and cancelling are O(1), and advancing costs O(1) per elapsed resolution step plus the
+ * timers which fire, no matter how many are pending. Delays are rounded up to the resolution and
+ * capped at 2^32 steps.
+ */
+class TimerWheel
+{
+    static const int levels = 4;
+    static const int bits = 8;
+    static const uint32_t slots = 1 << bits;
+    static const uint32_t mask = slots - 1;
+
+    struct Timer
+    {
+        function<void()> callback;
+        weak_ptr<void> owner;
+        bool owned = false;   ///< if set, the timer dies with its owner
+        uint64_t expires = 0; ///< step at which the timer fires
+        uint64_t period = 0;  ///< steps between firings, 0 for one shot timers
+        int32_t prev = -1;    ///< neighbours in the slot list
+        int32_t next = -1;
+        int32_t slot = -1;    ///< level * slots + index of the slot the timer is in, -1 if in none
+        uint32_t generation = 1;
+        bool active = false;
+    };
+
+    double resolution;
+    double remainder = 0; ///< time advanced but not yet making up a full step
+    uint64_t now_step = 0;
+    vector<Timer> timers;
+    vector<int32_t> free_timers;
+    vector<int32_t> heads; ///< first timer of each slot, levels * slots
+    vector<pair<int32_t, uint32_t>> firing; ///< index and generation of the timers due this step
+    size_t active_count = 0;
+
+    TimerId add(double delay, double period, function<void()> callback, weak_ptr<void> owner);
+    void insert(int32_t index);
+    void unlink(int32_t index);
+    void release(int32_t index);
+    void cascade(int level, uint32_t index);
+    void step();
+
+public:
+    /**
+     * @brief Construct a new TimerWheel
+     * @param resolution length of one step in seconds
+     */
+    TimerWheel(double resolution = 0.001);
+
+    /**
+     * @brief Call `callback` once, after `delay` seconds.
+     * @param owner if not empty, the timer is dropped once the owner is gone
+     * @return TimerId
+     */
+    TimerId schedule(double delay, function<void()> callback, weak_ptr<void> owner = weak_ptr<void>());
+
+    /**
+     * @brief Call `callback` every `period` seconds, the first time after one period.
+     * @param owner if not empty, the timer is dropped once the owner is gone
+     * @return TimerId
+     */
+    TimerId repeat(double period, function<void()> callback, weak_ptr<void> owner = weak_ptr<void>());
+
+    /**
+     * @brief Stop a timer. Safe to call from inside timer callbacks, and with ids of timers which already fired.
+     * @return true if the timer was pending
+     */
+    bool cancel(TimerId id);
+
+    bool isPending(TimerId id);
+
+    /**
+     * @brief Move time forward, firing every timer which comes due, in order.
+     * @param seconds
+     */
+    void advance(double seconds);
+
+    /**
+     * @brief Time advanced so far, in seconds, rounded down to the resolution.
+     */
+    double now()
+    {
+        return now_step * resolution;
+    }
+
+    size_t pending()
+    {
+        return active_count;
+    }
+};
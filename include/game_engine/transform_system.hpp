@@ -0,0 +1,113 @@
+/**
+ * @file transform_system.hpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief Transforms of all registered Object2Ds in flat arrays, propagated in one linear pass.
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include "std_includes.hpp"
+#include "vects.hpp"
+
+// defined here
+class TransformSystem;
+
+// extern
+class Object2D;
+
+/**
+ * @brief Keeps the local and world transform of every Object2D registered in an engine as structure of arrays,
+ * each parent before its children. update() recomputes every world transform in a single pass over the arrays,
+ * which the physics world and the graphic system then read instead of walking the hierarchy.
+ * Object2D writes its local transform through as it changes. An Object2D whose parent is not an Object2D of
+ * the same engine is a root.
+ */
+class TransformSystem
+{
+    vector<int> parent; ///< slot of the parent. Slot 0 is an identity transform, the parent of roots and free slots.
+    vector<float> local_x, local_y, local_rx, local_ry, local_scale;
+    vector<float> world_x, world_y, world_rx, world_ry, world_scale;
+    vector<Object2D *> owners; ///< null for free slots
+    size_t free_slots = 0;
+
+    /**
+     * @brief Drop the free slots, keeping the order of the others, and tell the objects their new slots.
+     */
+    void compact();
+
+    /**
+     * @brief Put an object and its Object2D descendants at the end, in depth first order.
+     */
+    void append(Object2D *obj);
+
+    /**
+     * @brief Give the object the next slot.
+     */
+    void insert(Object2D *obj);
+
+public:
+    TransformSystem();
+
+    ~TransformSystem();
+
+    /**
+     * @brief Give a slot to an object, after its parent's. Children which were given one first are moved after it.
+     * @param obj
+     */
+    void add(Object2D *obj);
+
+    /**
+     * @brief Free the slot of an object. Its descendants are expected to be removed as well.
+     * @param obj
+     */
+    void remove(Object2D *obj);
+
+    /**
+     * @brief Follow an object to its new parent, moving it and its descendants after the parent if need be.
+     * @param obj
+     */
+    void reparent(Object2D *obj);
+
+    /**
+     * @brief Write the local transform of a slot through.
+     */
+    void setLocal(int slot, Vect2f offset, Vect2f rotation, float scale)
+    {
+        local_x[slot] = offset.x;
+        local_y[slot] = offset.y;
+        local_rx[slot] = rotation.x;
+        local_ry[slot] = rotation.y;
+        local_scale[slot] = scale;
+    }
+
+    /**
+     * @brief Recompute all world transforms, parents first.
+     */
+    void update();
+
+    /**
+     * @brief World position as of the last update(), or of the object itself if it has no slot here.
+     * @param obj
+     * @return Vect2f
+     */
+    Vect2f position(Object2D *obj);
+
+    /**
+     * @brief World scale as of the last update(), or of the object itself if it has no slot here.
+     * @param obj
+     * @return float
+     */
+    float scale(Object2D *obj);
+
+    /**
+     * @brief Objects with a slot.
+     */
+    size_t size()
+    {
+        return owners.size() - 1 - free_slots;
+    }
+};
@@ -14,7 +14,6 @@
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_mixer.h>
 #include <vects.hpp> // Mathematical vectors
-#include <clock.h>   // clock/timer utility
 
 #include <box2d/box2d.h> 
 
@@ -76,7 +75,7 @@ public:
         {
             accel = accel * terminal_velocity / accel.length();
         }
-        offset = offset + accel * delta; // bad for small delta; typing is hard as pos migth require some FLOPS
+        setOffset(getOffset() + accel * delta); // bad for small delta; typing is hard as pos migth require some FLOPS
         Object::loop(delta);
     }
 };
@@ -99,32 +98,45 @@ public:
 
 class PipeSpawner : public Object2D
 {
-public:
-    Clock time;
+    shared_ptr<Prefab> pipes;
 
-    void loop(double delta) override
+public:
+    void init() override
     {
-        if(time.get_time() < 2.5)
-            return;
-        time.start_timer();
-
-        add(make_shared<Object2D>());
-        get<Object2D>(0)->offset = {500, 500 + (float)(rand() % 200)};
-        get(0)->add(getEngine()->get<Texture>("Texture")->buildSprite("green_pipe_bellow"));
-        get<Sprite>("Object2D/Sprite")->scaleX(100);
-        get<Sprite>("Object2D/Sprite")->offset = {0, 75};
-        get(0)->add(make_shared<PhysicsObject>(get<Sprite>("Object2D/Sprite")->offset, get<Sprite>("Object2D/Sprite")->getSize(), b2_kinematicBody));
-        get(0)->add(getEngine()->get<Texture>("Texture")->buildSprite("green_pipe_above"));
-        get<Sprite>("Object2D/Sprite_1")->scaleX(100);
-        get<Sprite>("Object2D/Sprite_1")->offset = {0, -75 - get<Sprite>("Object2D/Sprite_1")->getSize().y};
-        get(0)->add(make_shared<PhysicsObject>(get<Sprite>("Object2D/Sprite_1")->offset, get<Sprite>("Object2D/Sprite_1")->getSize(), b2_kinematicBody));
-        get(0)->attachLoopBehaviour([](Object *self, double delta){
+        Object2D::init();
+        pipes = make_shared<Prefab>(buildPipe(), 4); // pipes leave the screen about as fast as new ones come
+        weak_ptr<Prefab> prefab = pipes;
+        pipes->getPrototype()->attachLoopBehaviour([prefab](Object *self, double delta){
             shared_ptr<Object2D> t_self = static_pointer_cast<Object2D>(self->shared_from_this());
-            t_self->offset.x -= 100 * delta;
-            if(t_self->offset.x < -100)
-                t_self->getParent()->removeChild(t_self->getName());
+            t_self->setOffset(t_self->getOffset() - Vect2f(100 * delta, 0));
+            auto pipes = prefab.lock();
+            if(t_self->getOffset().x < -100 && pipes)
+                pipes->release(t_self);
         });
-        getEngine()->add(removeChild(0));
+        every(2.5, [this]() { spawn(); });
+    }
+
+    shared_ptr<Object2D> buildPipe()
+    {
+        static const NodePath below("Sprite"), above("Sprite_1");
+        auto texture = getEngine()->get<Texture>("Texture");
+        auto pipe = make_shared<Object2D>();
+        pipe->add(texture->buildSprite("green_pipe_bellow"));
+        pipe->get<Sprite>(below)->scaleX(100);
+        pipe->get<Sprite>(below)->setOffset({0, 75});
+        pipe->add(make_shared<PhysicsObject>(pipe->get<Sprite>(below)->getOffset(), pipe->get<Sprite>(below)->getSize(), b2_kinematicBody));
+        pipe->add(texture->buildSprite("green_pipe_above"));
+        pipe->get<Sprite>(above)->scaleX(100);
+        pipe->get<Sprite>(above)->setOffset({0, -75 - pipe->get<Sprite>(above)->getSize().y});
+        pipe->add(make_shared<PhysicsObject>(pipe->get<Sprite>(above)->getOffset(), pipe->get<Sprite>(above)->getSize(), b2_kinematicBody));
+        return pipe;
+    }
+
+    void spawn()
+    {
+        auto pipe = pipes->instantiate<Object2D>();
+        pipe->setOffset({500, 500 + (float)(getEngine()->rng() % 200)});
+        getEngine()->add(pipe); // recycled pipes are there already
     }
 };
 
@@ -136,10 +148,32 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int n
 int main(int argc, char **argv)
 #endif
 {
-    Engine::enable();
-    // TODO: deepcpy for object cloning, analog to packed scenes in godot
+    EngineConfig config;
+    config.window_size = {400, 720};
+    config.gravity = {0, 2000};
+    unsigned long headless_ticks = 0;
+    string record_path, replay_path;
+#ifndef __WIN32__
+    // `main --headless <ticks>` runs the game without a window as fast as possible
+    // `main --record <file>` records the input of a session, `main --replay <file>` plays it back headless
+    if (argc > 2 && string(argv[1]) == "--headless")
+    {
+        config.headless = true;
+        headless_ticks = std::stoul(argv[2]);
+    }
+    else if (argc > 2 && string(argv[1]) == "--record")
+        record_path = argv[2];
+    else if (argc > 2 && string(argv[1]) == "--replay")
+    {
+        config.headless = true;
+        replay_path = argv[2];
+    }
+#endif
+    Engine::enable(config.headless);
+    Engine::setPassive<PipeSpawner>(); // spawns from a timer, nothing to do per tick
     
-    auto e = make_shared<Engine>(Vect2i(400, 720), Vect2f(0, 2000));
+    auto e = make_shared<Engine>(config);
+    e->setFixedStep(60);
     e->add(Button::create());
     e->get<Button>("Button")->base_size = {400, 720};
 
@@ -157,28 +191,28 @@ int main(int argc, char **argv)
     
     // backround
     e->add(e->get<Texture>("Texture")->buildSprite("background"));
-    e->get<Sprite>("Sprite")->offset = {400/2, 720/2};
+    e->get<Sprite>("Sprite")->setOffset({400/2, 720/2});
     e->get<Sprite>("Sprite")->scaleY(720);
     e->get<Sprite>("Sprite")->setDrawHeight(-2);
     
     // floor
     e->add(make_shared<PhysicsObject>(Vect2f(0, 0), Vect2f(420,168), b2_staticBody));
-    e->get<PhysicsObject>("PhysicsObject")->offset = {400/2, 650};
+    e->get<PhysicsObject>("PhysicsObject")->setOffset({400/2, 650});
     e->get("PhysicsObject")->add(e->get<Texture>("Texture")->buildSprite("floor"));
     e->get<Sprite>("PhysicsObject/Sprite")->scaleX(480);
     e->get<Sprite>("PhysicsObject/Sprite")->setDrawHeight(1);
     e->get<Sprite>("PhysicsObject/Sprite")->attachLoopBehaviour([](Object *self, double delta){
         shared_ptr<Object2D> t_self = static_pointer_cast<Object2D>(self->shared_from_this());
-        t_self->offset.x -= 100 * delta;
-        if(t_self->offset.x < -36)
-            t_self->offset.x = 0;
+        t_self->setOffset(t_self->getOffset() - Vect2f(100 * delta, 0));
+        if(t_self->getOffset().x < -36)
+            t_self->setOffset({0, t_self->getOffset().y});
     });
     
 
     // bird
     auto bird = make_shared<PhysicsObject>(Vect2f(0,0), Vect2f(6,6), b2_dynamicBody);
     bird->attachInitBehaviour([](Object *self){
-        static_cast<Object2D*>(self)->offset = {100, 100};
+        static_cast<Object2D*>(self)->setOffset({100, 100});
         auto sprite = self->getEngine()->get<Texture>("Texture")->buildSprite("bird");
         sprite->scaleX(84);
         sprite->setDrawHeight(2);
@@ -199,7 +233,17 @@ int main(int argc, char **argv)
 
     // pipes
     e->add(make_shared<PipeSpawner>());
-    e->start();
+    if (!replay_path.empty())
+        std::cout << "Ticks per second: " << e->replay(replay_path) << '\n';
+    else if (config.headless)
+        std::cout << "Ticks per second: " << e->step(headless_ticks) << '\n';
+    else
+    {
+        if (!record_path.empty())
+            e->startRecording(record_path);
+        e->start();
+        e->stopRecording();
+    }
 
     Engine::disable();
     return 0;
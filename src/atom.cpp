@@ -0,0 +1,67 @@
+/**
+ * @file atom.cpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <atom.hpp>
+
+namespace
+{
+    // looks strings up by string_view, so that finding an interned one does not build a string
+    struct TextHash
+    {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view text) const
+        {
+            return std::hash<std::string_view>()(text);
+        }
+    };
+
+    typedef unordered_set<string, TextHash, std::equal_to<>> Table;
+
+    // constructed on first use, so that atoms may be made during static initialization
+    std::shared_mutex &tableMutex()
+    {
+        static std::shared_mutex table_mutex; // shared by lookups, which are most uses once names are interned
+        return table_mutex;
+    }
+
+    Table &table()
+    {
+        static Table strings; // nodes keep their address across rehashing
+        return strings;
+    }
+}
+
+Atom::Atom(std::string_view text)
+{
+    if (text.empty())
+        return;
+    auto found = find(text);
+    if (found)
+    {
+        *this = *found;
+        return;
+    }
+    std::lock_guard<std::shared_mutex> lock(tableMutex());
+    this->text = &*table().emplace(text).first; // or the one interned since the lookup
+}
+
+std::optional<Atom> Atom::find(std::string_view text)
+{
+    if (text.empty())
+        return Atom();
+    std::shared_lock<std::shared_mutex> lock(tableMutex());
+    auto it = table().find(text);
+    if (it == table().end())
+        return std::nullopt;
+    Atom atom;
+    atom.text = &*it;
+    return atom;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file child_list.cpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <child_list.hpp>
+#include <objects.hpp>
+
+bool ChildList::contains(const Object *child) const
+{
+    return child->child_entry < entries.size() && entries[child->child_entry].get() == child;
+}
+
+void ChildList::push_back(shared_ptr<Object> child)
+{
+    // compacting here keeps the vector bounded when children come and go, in O(1) per removal over time
+    if (removed > 32 && removed * 2 > entries.size())
+        compact();
+    child->child_entry = entries.size();
+    entries.push_back(std::move(child));
+    if (live.empty())
+        return;
+    // the new node counts the entries of its range before it, plus itself
+    size_t node = entries.size();
+    uint32_t sum = 1;
+    for (size_t below = node - 1, low = node - (node & -node); below > low; below -= below & -below)
+        sum += live[below - 1];
+    live.push_back(sum);
+    if ((size_t)top_bit * 2 <= live.size())
+        top_bit *= 2;
+}
+
+bool ChildList::erase(const Object *child)
+{
+    if (!contains(child))
+        return false;
+    size_t entry = child->child_entry;
+    entries[entry].reset();
+    removed++;
+    while (head < entries.size() && entries[head] == nullptr)
+        head++;
+    for (size_t node = entry + 1; node <= live.size(); node += node & -node)
+        live[node - 1]--;
+    return true;
+}
+
+const shared_ptr<Object> &ChildList::at(size_t index)
+{
+    if (index >= size())
+        throw std::out_of_range("Index out of range");
+    if (removed == head)
+        return entries[head + index]; // no gaps past the front
+    if (live.empty())
+        count();
+    // the entry with `index` live ones before it
+    size_t node = 0;
+    size_t rest = index;
+    for (size_t step = top_bit; step > 0; step /= 2)
+    {
+        if (node + step <= live.size() && live[node + step - 1] <= rest)
+        {
+            node += step;
+            rest -= live[node - 1];
+        }
+    }
+    return entries[node];
+}
+
+void ChildList::count()
+{
+    live.assign(entries.size(), 0);
+    for (size_t node = 1; node <= live.size(); node++)
+    {
+        live[node - 1] += entries[node - 1] != nullptr;
+        size_t parent = node + (node & -node);
+        if (parent <= live.size())
+            live[parent - 1] += live[node - 1];
+    }
+    top_bit = 1;
+    while ((size_t)top_bit * 2 <= live.size())
+        top_bit *= 2;
+}
+
+void ChildList::compact()
+{
+    size_t next = 0;
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        if (entries[i] == nullptr)
+            continue;
+        entries[i]->child_entry = next;
+        if (i != next)
+            entries[next] = std::move(entries[i]);
+        next++;
+    }
+    entries.resize(next);
+    removed = 0;
+    head = 0;
+    live.clear(); // rebuilt once gaps need it again
+}
@@ -0,0 +1,120 @@
+/**
+ * @file coroutine.cpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <coroutine.hpp>
+
+#include <engine.hpp>
+#include <dispatcher.hpp>
+
+namespace
+{
+    const size_t frame_granularity = 64;
+    const size_t frame_classes = 32; // frames over 2 KiB go to the heap
+
+    struct FrameLists
+    {
+        vector<void *> free[frame_classes];
+
+        ~FrameLists()
+        {
+            for (auto &list : free)
+                for (void *frame : list)
+                    ::operator delete(frame);
+        }
+    };
+
+    thread_local FrameLists frame_lists;
+
+    shared_ptr<Engine> ownerEngine(Behaviour::Handle handle)
+    {
+        Object *owner = handle.promise().owner;
+        shared_ptr<Engine> engine = owner ? owner->getEngine() : nullptr;
+        if (!engine)
+            throw std::runtime_error("Behaviour awaited outside of an engine");
+        return engine;
+    }
+}
+
+void *FramePool::allocate(size_t size)
+{
+    size_t size_class = (size + frame_granularity - 1) / frame_granularity;
+    if (size_class >= frame_classes)
+        return ::operator new(size);
+    auto &list = frame_lists.free[size_class];
+    if (list.empty())
+        return ::operator new(size_class * frame_granularity);
+    void *frame = list.back();
+    list.pop_back();
+    return frame;
+}
+
+void FramePool::deallocate(void *frame, size_t size)
+{
+    size_t size_class = (size + frame_granularity - 1) / frame_granularity;
+    if (size_class >= frame_classes)
+        ::operator delete(frame);
+    else
+        frame_lists.free[size_class].push_back(frame); // may be another thread's frame, the blocks are plain heap memory
+}
+
+Behaviour &Behaviour::operator=(Behaviour &&other) noexcept
+{
+    if (this != &other)
+    {
+        if (handle)
+            handle.destroy();
+        handle = std::exchange(other.handle, nullptr);
+    }
+    return *this;
+}
+
+Behaviour::~Behaviour()
+{
+    if (handle)
+        handle.destroy();
+}
+
+void Behaviour::start(Object *owner)
+{
+    handle.promise().owner = owner;
+    resume(handle);
+}
+
+void Behaviour::resume(Handle handle)
+{
+    handle.resume();
+    if (handle.promise().exception)
+        std::rethrow_exception(std::exchange(handle.promise().exception, nullptr));
+}
+
+void DelayAwaiter::await_suspend(Behaviour::Handle handle)
+{
+    ownerEngine(handle)->timers->schedule(seconds, [handle]()
+    {
+        Behaviour::resume(handle);
+    }, handle.promise().alive);
+}
+
+void NextTickAwaiter::await_suspend(Behaviour::Handle handle)
+{
+    ownerEngine(handle)->onNextTick(handle.promise().alive, [handle]()
+    {
+        Behaviour::resume(handle);
+    });
+}
+
+void EventAwaiterBase::suspend(Behaviour::Handle handle, size_t event_type)
+{
+    ownerEngine(handle)->disp->waitForEvent(event_type, handle.promise().alive, [this, handle](shared_ptr<Event> e)
+    {
+        event = e;
+        Behaviour::resume(handle);
+    });
+}
@@ -11,6 +11,7 @@
 #include <dispatcher.hpp>
 
 #include <events.hpp>
+#include <profiler.hpp>
 
 EventDispatcher::EventDispatcher()
 {
@@ -28,6 +29,11 @@ void EventDispatcher::unregisterEventHandler(shared_ptr<HandlerI> handle)
     handles.erase(handle);
 }
 
+void EventDispatcher::waitForEvent(size_t event_type, weak_ptr<void> owner, function<void(shared_ptr<Event>)> callback)
+{
+    waiters[event_type].push_back({std::move(owner), std::move(callback)});
+}
+
 void EventDispatcher::addEvent(shared_ptr<Event> e)
 {
     back_m.lock();
@@ -37,6 +43,7 @@ void EventDispatcher::addEvent(shared_ptr<Event> e)
 
 void EventDispatcher::dispatch()
 {
+    PROFILE_ZONE("EventDispatcher::dispatch");
     back_m.lock();
     auto temp = back;
     back = front;
@@ -47,11 +54,20 @@ void EventDispatcher::dispatch()
     {
         auto event = front->front();
         front->pop();
+        auto hash = typeid(*event.get()).hash_code();
         for (auto &handler : handles)
         {
-            auto hash = typeid(*event.get()).hash_code();
             if (handler->event_type == hash)
                 (*handler)(event);
         }
+        auto waiting = waiters.find(hash);
+        if (waiting == waiters.end() || waiting->second.empty())
+            continue;
+        // waits made by the callbacks are for the next event
+        woken.swap(waiting->second);
+        for (auto &waiter : woken)
+            if (!waiter.owner.expired())
+                waiter.callback(event);
+        woken.clear();
     }
 }
@@ -17,6 +17,9 @@ class KeyboardEvent;
 #include <objects.hpp>
 #include <events.hpp>
 #include <physics.hpp>
+#include <job_system.hpp>
+#include <logger.hpp>
+#include <profiler.hpp>
 
 shared_ptr<Event> HardwareEventBuilder::build(SDL_Event e)
 {
@@ -28,60 +31,811 @@ shared_ptr<Event> HardwareEventBuilder::build(SDL_Event e)
         return shared_ptr<Event>();
 }
 
-Engine::Engine(Vect2i window_size, Vect2f gravity, double tick_delay)
+namespace
 {
-    gsys = make_shared<GraphicSystem>(window_size);
+    mutex enable_m;
+    int enable_count = 0;
+    typedef std::chrono::duration<double, std::milli> millis;
+}
+
+thread_local int Engine::parallel_depth = 0;
+
+int Engine::enable(bool headless)
+{
+    std::lock_guard<mutex> lock(enable_m);
+    if (enable_count++ > 0)
+        return 0;
+    if (headless)
+    {
+        SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+        SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+    }
+    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS | SDL_INIT_AUDIO) < 0)
+    {
+        std::cerr << "Failed to initialize SDL_subsystems: " << SDL_GetError() << '\n';
+        enable_count--;
+        return 1;
+    }
+    if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 8, 2048) < 0)
+    {
+        std::cerr << "Failed to initialize SDL_mixer: " << Mix_GetError() << '\n';
+        SDL_Quit();
+        enable_count--;
+        return 1;
+    }
+    return 0;
+}
+
+void Engine::disable()
+{
+    std::lock_guard<mutex> lock(enable_m);
+    if (enable_count == 0 || --enable_count > 0)
+        return;
+    Logger::instance().flush();
+    Mix_CloseAudio();
+    SDL_Quit();
+}
+
+namespace
+{
+    EngineConfig makeConfig(Vect2i window_size, Vect2f gravity, double tick_rate)
+    {
+        EngineConfig config;
+        config.window_size = window_size;
+        config.gravity = gravity;
+        config.tick_rate = tick_rate;
+        return config;
+    }
+}
+
+Engine::Engine(Vect2i window_size, Vect2f gravity, double tick_rate)
+    : Engine(makeConfig(window_size, gravity, tick_rate))
+{}
+
+Engine::Engine(EngineConfig config)
+{
+    this->config = config;
+    gsys = make_shared<GraphicSystem>(config.window_size, config.headless, config.vsync);
     disp = make_shared<EventDispatcher>();
-    world = make_shared<World>(gravity);
+    world = make_shared<World>(config.gravity);
     root = make_shared<Object>();
-    tick_delay = 1.0f / tick_delay;
+    workers = config.job_system ? config.job_system : make_shared<JobSystem>(config.worker_threads);
+    timers = make_shared<TimerWheel>();
+    transforms = make_shared<TransformSystem>();
+    gsys->transforms = transforms.get();
+    world->transforms = transforms.get();
+    clock = make_shared<EngineClock>();
+    input = make_shared<InputSystem>();
+    command_buffers.resize(workers->concurrency());
+    pacer.setRate(config.headless ? 0 : frameRate()); // headless runs unpaced
+    if (!config.headless)
+        pacer.setIdle([this]
+                      { input->pump(); }); // stamp events close to when they arrive, not when the frame starts
+    setSeed(config.seed != 0 ? config.seed : std::random_device()());
     registerObj(root);
-    registerObj(make_shared<EngineController>()); // does not exist in root, only bucket - bad
+    controller = make_shared<EngineController>(); // does not exist in root, only bucket - bad
+}
+
+Engine::~Engine()
+{
+    // objects held elsewhere outlive the engine, and must not reach it through their engine pointer
+    for (auto &obj : bucket)
+        obj->engine_ptr = nullptr;
+    for (auto &buffer : command_buffers)
+        for (auto &command : buffer)
+            if (command.obj && command.obj->engine_ptr == this)
+                command.obj->engine_ptr = nullptr;
+    for (auto &command : foreign_commands)
+        if (command.obj && command.obj->engine_ptr == this)
+            command.obj->engine_ptr = nullptr;
+}
+
+void Engine::setFixedStep(double tick_rate, int max_catchup_steps)
+{
+    fixed_delta = tick_rate > 0 ? 1.0 / tick_rate : 0;
+    this->max_catchup_steps = max_catchup_steps > 0 ? max_catchup_steps : 1;
+    accumulator = 0;
+}
+
+void Engine::setSeed(uint32_t seed)
+{
+    this->seed = seed;
+    rng.seed(seed);
+}
+
+void Engine::startRecording(string path)
+{
+    if (fixed_delta <= 0)
+        setFixedStep(config.tick_rate);
+    rng.seed(seed);
+    recorder = make_unique<ReplayWriter>(path, seed, 1.0 / fixed_delta, tick_count);
+}
+
+void Engine::stopRecording()
+{
+    if (!recorder)
+        return;
+    recorder->finish(tick_count);
+    recorder.reset();
+}
+
+double Engine::replay(string path)
+{
+    player = make_unique<ReplayReader>(path, tick_count);
+    setSeed(player->seed);
+    setFixedStep(player->tick_rate);
+    double ticks_per_second;
+    try
+    {
+        ticks_per_second = step(player->getLength());
+    }
+    catch (...)
+    {
+        player.reset();
+        throw;
+    }
+    player.reset();
+    return ticks_per_second;
+}
+
+void Engine::pollEvents()
+{
+    PROFILE_ZONE("SDL_PollEvent");
+    SDL_Event e;
+    if (player)
+    {
+        // events are dispatched by the next tick, the same one as when they were recorded
+        while (player->next(tick_count, e))
+            disp->addEvent(HardwareEventBuilder::build(e));
+        return;
+    }
+    if (gsys->isHeadless())
+        return;
+    for (auto &sample : input->take(tick_count, presenting))
+    {
+        if (sample.event.type == SDL_QUIT)
+        {
+            is_stopped = true;
+            break;
+        }
+        else
+        {
+            auto event = HardwareEventBuilder::build(sample.event);
+            if (event.get() != nullptr)
+            {
+                disp->addEvent(event);
+                if (recorder)
+                    recorder->write(tick_count, sample.event);
+            }
+        }
+    }
 }
 
 void Engine::start()
 {
-    if (!run.try_lock())
+    std::unique_lock<std::mutex> running(run, std::try_to_lock);
+    if (!running.owns_lock())
         throw std::runtime_error("Engine already running!");
     is_stopped = false;
-    while (!is_stopped)
+    free_running = true;
+    registerObj(controller); // no-op after the first run
+    pacer.reset();
+    if (config.pipelined && !gsys->isHeadless() && !recorder)
+        runPipelined();
+    else
     {
-        // update hardware events
-        SDL_Event e;
-        while (SDL_PollEvent(&e))
+        presenting = true;
+        while (!is_stopped)
         {
-            if (e.type == SDL_QUIT)
+            auto delta = pacer.wait();
+            auto begin = std::chrono::steady_clock::now();
+            // update hardware events, right after the wait which kept pumping them
+            pollEvents();
+            auto polled = std::chrono::steady_clock::now();
+            LOG_TRACE("Delta: ({})", delta);
+            LOG_TRACE("Tick start");
+            float alpha = simulate(delta);
+            auto simulated = std::chrono::steady_clock::now();
+            bool skipped = skipRender();
+            if (skipped)
+                load.skipped_renders++;
+            else
             {
-                is_stopped = true;
-                break;
+                if (!gsys->isHeadless())
+                    input->latch();
+                gsys->update(alpha);
+                input->presented(tick_count);
             }
-            else
+            LOG_TRACE("Tick end");
+            auto end = std::chrono::steady_clock::now();
+            millis input_time = polled - begin, simulation_time = simulated - polled, render_time = end - simulated;
+            recordFrame(input_time.count(), simulation_time.count(), skipped ? -1 : render_time.count(), delta * 1000);
+            std::chrono::duration<double> work = end - begin;
+            trackLoad(work.count());
+            PROFILE_FRAME();
+        }
+        presenting = false;
+    }
+    free_running = false;
+    PacerStats paced = pacer.getStats();
+    LOG_INFO("Frame pacing (ms): mean {}, jitter {}, worst {}, late frames {}",
+        paced.mean, paced.jitter, paced.worst, paced.late);
+    LatencyStats latency = input->getLatency();
+    LOG_INFO("Input to present latency (ms): p50 {}, p90 {}, p99 {}, max {}",
+        latency.p50, latency.p90, latency.p99, latency.max);
+    LOG_INFO("Load: {} overruns, {} capped frames, {} overload periods, {} skipped renders",
+        load.overruns, load.capped_frames, load.overload_periods, load.skipped_renders);
+}
+
+void Engine::updatePhysics(double delta)
+{
+    auto begin = std::chrono::steady_clock::now();
+    if (config.physics_rate <= 0)
+    {
+        if (delta > 0)
+            world->update(delta);
+    }
+    else
+    {
+        // steps due by now, counted from the simulated time so that runs with the same ticks step alike
+        auto due = (unsigned long)std::floor(clock->now() * config.physics_rate + 1e-6);
+        for (; physics_steps < due; physics_steps++)
+            world->update(1 / config.physics_rate);
+    }
+    millis elapsed = std::chrono::steady_clock::now() - begin;
+    physics_time += elapsed.count();
+    transforms->update(); // once per tick, for rendering
+}
+
+void Engine::recordFrame(double input, double simulation, double render, double frame)
+{
+    std::lock_guard<mutex> lock(stats_m);
+    if (input >= 0)
+        input_times.add(input);
+    if (render >= 0)
+        render_times.add(render);
+    if (frame >= 0)
+        frame_times.add(frame);
+    if (simulation < 0)
+        return;
+    physics_times.add(physics_time);
+    simulation_times.add(std::max(0.0, simulation - physics_time));
+    physics_time = 0;
+    // only the simulating thread touches what is counted here
+    EngineStats &counts = counts_published;
+    counts.ticks = tick_count;
+    counts.sim_time = clock->now();
+    counts.objects = bucket.size();
+    counts.looping_objects = 0;
+    for (auto &list : loops)
+        for (auto &group : list)
+            counts.looping_objects += group.second.size();
+    counts.handlers = disp->handles.size();
+    counts.graphic_objects = gsys->bucket.size();
+    counts.physics_bodies = world->bucket.size();
+    counts.pending_timers = timers->pending();
+}
+
+EngineStats Engine::getStats()
+{
+    std::lock_guard<mutex> lock(stats_m);
+    EngineStats stats = counts_published;
+    stats.input = input_times.summary();
+    stats.simulation = simulation_times.summary();
+    stats.physics = physics_times.summary();
+    stats.render = render_times.summary();
+    stats.frame = frame_times.summary();
+    return stats;
+}
+
+float Engine::simulate(double delta)
+{
+    delta = clock->frame(delta, tickLength());
+    if (clock->isPaused())
+    {
+        if (recorder)
+            recorder->paused(tick_count); // replayed with zero length as well
+        tick(0); // keeps dispatching events, so that something can unpause
+        updatePhysics(0);
+        return fixed_delta > 0 ? accumulator / fixed_delta : 1;
+    }
+    if (fixed_delta <= 0)
+    {
+        // a long frame makes for a long tick, which makes the next frame longer still
+        double max_delta = config.tick_rate > 0 ? max_catchup_steps / config.tick_rate : 0;
+        if (max_delta > 0 && delta > max_delta)
+        {
+            load.capped_frames++;
+            load.dropped_time += delta - max_delta;
+            delta = max_delta;
+        }
+        tick(delta);
+        updatePhysics(delta);
+        return 1;
+    }
+    accumulator += delta;
+    int steps = 0;
+    while (accumulator >= fixed_delta && steps < max_catchup_steps)
+    {
+        gsys->snapshot();
+        tick(fixed_delta);
+        updatePhysics(fixed_delta);
+        accumulator -= fixed_delta;
+        steps++;
+    }
+    // out of catch-up steps, drop the backlog instead of spiraling into ever longer frames
+    if (accumulator >= fixed_delta)
+    {
+        double kept = std::fmod(accumulator, fixed_delta);
+        load.capped_frames++;
+        load.dropped_time += accumulator - kept;
+        accumulator = kept;
+    }
+    return accumulator / fixed_delta;
+}
+
+void Engine::trackLoad(double work)
+{
+    double budget = frameRate() > 0 ? 1 / frameRate() : 0;
+    if (budget <= 0 || gsys->isHeadless())
+        return; // unpaced, there is no budget to overrun
+    if (work > budget)
+    {
+        load.overruns++;
+        overrun_streak++;
+        calm_streak = 0;
+    }
+    else
+    {
+        overrun_streak = 0;
+        // leaving takes longer than entering, and needs headroom, or shedding would flip on and off
+        calm_streak = work < budget * 0.75 ? calm_streak + 1 : 0;
+    }
+    if (!load.overloaded && config.overload_frames > 0 && overrun_streak >= config.overload_frames)
+    {
+        load.overloaded = true;
+        load.overload_periods++;
+        LOG_WARN("Engine overloaded, shedding load");
+    }
+    else if (load.overloaded && calm_streak >= config.overload_frames * 4)
+        load.overloaded = false;
+    if (load.overloaded)
+        load.overloaded_frames++;
+    std::lock_guard<mutex> lock(stats_m);
+    load_published = load;
+}
+
+bool Engine::skipRender()
+{
+    if (!load.overloaded || skipped_in_row >= config.max_skipped_renders)
+    {
+        skipped_in_row = 0;
+        return false;
+    }
+    skipped_in_row++;
+    return true;
+}
+
+void Engine::runPipelined()
+{
+    using std::chrono::steady_clock;
+    const double smoothing = 0.05; // weight of the newest frame in the averages
+    FramePipeline pipeline;
+    std::exception_ptr error; // out of the simulation thread, rethrown here once it is joined
+
+    std::thread simulation([this, &pipeline, &error, smoothing]()
+    {
+        auto last = steady_clock::now();
+        try
+        {
+            while (!is_stopped)
             {
-                auto event = HardwareEventBuilder::build(e);
-                if (event.get() != nullptr)
-                    disp->addEvent(event);
+                auto begin = steady_clock::now();
+                std::chrono::duration<double> delta = begin - last;
+                last = begin;
+                float alpha = simulate(delta.count());
+                auto simulated = steady_clock::now();
+                gsys->record(pipeline.back(), alpha);
+                millis busy = steady_clock::now() - begin;
+                millis simulation_time = simulated - begin;
+                recordFrame(-1, simulation_time.count(), -1, -1);
+                trackLoad(busy.count() / 1000); // renders are never skipped here, they run on the other thread
+                {
+                    std::lock_guard<mutex> lock(stats_m);
+                    pipeline_stats.simulation += (busy.count() - pipeline_stats.simulation) * smoothing;
+                }
+                PROFILE_FRAME();
+                if (!pipeline.publish())
+                    break;
             }
         }
-        auto delta = clock.delta_time(tick_delay);
-        std::cout << string() + "Delta: (" + std::to_string(delta) + ")" << '\n';
-        std::cout << "Tick start\n";
-        for (const auto& obj : dead_bucket)
-            bucket.erase(obj);
-        dead_bucket.clear(); 
+        catch (...)
+        {
+            error = std::current_exception();
+            is_stopped = true;
+            pipeline.stop();
+        }
+    });
+
+    auto last_present = steady_clock::now();
+    while (!is_stopped)
+    {
+        auto poll_begin = steady_clock::now();
+        pollEvents();
+        millis input_time = steady_clock::now() - poll_begin;
+        pacer.wait();
+        // time out now and then to keep polling events while the simulation is slow
+        const DrawList *frame = pipeline.acquire(std::chrono::milliseconds(100));
+        if (frame == nullptr)
+        {
+            recordFrame(input_time.count(), -1, -1, -1);
+            continue;
+        }
+        auto begin = steady_clock::now();
+        gsys->submit(*frame);
+        pipeline.release();
+        auto end = steady_clock::now();
+        millis render = end - begin;
+        millis frame_time = end - last_present;
+        last_present = end;
+        recordFrame(input_time.count(), -1, render.count(), frame_time.count());
+        std::lock_guard<mutex> lock(stats_m);
+        pipeline_stats.render += (render.count() - pipeline_stats.render) * smoothing;
+        pipeline_stats.frame += (frame_time.count() - pipeline_stats.frame) * smoothing;
+        pipeline_stats.recovered = pipeline_stats.simulation + pipeline_stats.render - pipeline_stats.frame;
+    }
+    pipeline.stop();
+    simulation.join();
+    if (error)
+        std::rethrow_exception(error);
+    LOG_INFO("Pipelined frame (ms): simulation {}, render {}, frame {}, recovered {}",
+        pipeline_stats.simulation, pipeline_stats.render, pipeline_stats.frame, pipeline_stats.recovered);
+}
+
+double Engine::step(unsigned long ticks)
+{
+    std::unique_lock<std::mutex> running(run, std::try_to_lock);
+    if (!running.owns_lock())
+        throw std::runtime_error("Engine already running!");
+    is_stopped = false;
+    free_running = false; // runs exactly the ticks asked for
+    registerObj(controller); // no-op after the first run
+    double delta = tickLength();
+    auto begin = std::chrono::steady_clock::now();
+    unsigned long done = 0;
+    for (; done < ticks && !is_stopped; done++)
+    {
+        auto tick_begin = std::chrono::steady_clock::now();
+        pollEvents();
+        auto polled = std::chrono::steady_clock::now();
+        // a replay runs the ticks which were recorded while paused with zero length, as simulate() did
+        double length = player && player->paused(tick_count) ? 0 : delta;
+        if (fixed_delta > 0 && length > 0)
+            gsys->snapshot();
+        tick(length);
+        updatePhysics(length);
+        auto simulated = std::chrono::steady_clock::now();
+        gsys->update(); // no-op when headless
+        auto end = std::chrono::steady_clock::now();
+        millis input_time = polled - tick_begin, simulation_time = simulated - polled, render_time = end - simulated, frame = end - tick_begin;
+        recordFrame(input_time.count(), simulation_time.count(), render_time.count(), frame.count());
+        PROFILE_FRAME();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+    running.unlock();
+    if (elapsed.count() <= 0)
+        return 0;
+    return done / elapsed.count();
+}
+
+double Engine::stepAll(const vector<shared_ptr<Engine>> &engines, unsigned long ticks, JobSystem &pool)
+{
+    auto begin = std::chrono::steady_clock::now();
+    std::atomic<unsigned long> done(0);
+    mutex error_m;
+    std::exception_ptr error;
+    {
+        TaskGroup group(pool);
+        for (auto &engine : engines)
+            group.run([&engine, &done, &error_m, &error, ticks]()
+            {
+                unsigned long before = engine->getTickCount();
+                try
+                {
+                    engine->step(ticks);
+                }
+                catch (...)
+                {
+                    std::lock_guard<mutex> lock(error_m);
+                    if (!error)
+                        error = std::current_exception();
+                }
+                done += engine->getTickCount() - before;
+            });
+        group.wait();
+    }
+    if (error)
+        std::rethrow_exception(error); // the first failure, the other engines ran to the end
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+    if (elapsed.count() <= 0)
+        return 0;
+    return done / elapsed.count();
+}
+
+double Engine::runFor(double seconds)
+{
+    double delta = tickLength();
+    return step((unsigned long)std::llround(seconds / delta));
+}
+
+void Engine::tick(double delta)
+{
+    tick_thread = std::this_thread::get_id();
+    ticking = true;
+    clock->advance(delta);
+    next_tick_running.swap(next_tick);
+    size_t called = 0;
+    try
+    {
+        while (called < next_tick_running.size())
+        {
+            auto &call = next_tick_running[called++];
+            if (!call.first.expired())
+                call.second();
+        }
+        next_tick_running.clear();
+        called = 0;
         this->update(delta);
+        timers->advance(delta);
         disp->dispatch();
-        gsys->update();
-        world->update();
-        std::cout << "Tick end\n\n";
     }
-    run.unlock();
+    catch (...)
+    {
+        // calls not reached are left for the next tick, the ones made, the failed one too, are never made again
+        next_tick.insert(next_tick.begin(), std::make_move_iterator(next_tick_running.begin() + called),
+            std::make_move_iterator(next_tick_running.end()));
+        next_tick_running.clear();
+        ticking = false;
+        applyCommands(); // what ran of the tick leaves the scene consistent
+        tick_count++;
+        throw;
+    }
+    ticking = false;
+    applyCommands();
+    tick_count++;
+}
+
+set<std::type_index> &Engine::passiveTypes()
+{
+    static set<std::type_index> types = {
+        typeid(Object), typeid(Object2D), typeid(Texture), typeid(Sprite), typeid(AudioPlayer), typeid(PhysicsObject),
+        typeid(EngineController)};
+    return types;
+}
+
+bool Engine::needsLoop(Object *obj)
+{
+    if (!obj->active)
+        return false;
+    if (obj->loop_behavior)
+        return true;
+    return passiveTypes().count(typeid(*obj)) == 0;
+}
+
+void Engine::refreshLoop(Object *obj)
+{
+    if (ticking)
+    {
+        record({EngineCommand::REFRESH_LOOP, obj->shared_from_this(), nullptr});
+        return;
+    }
+    bool registered = obj->engine_ptr == this;
+    bool wanted = registered && needsLoop(obj);
+    int list = (obj->thread_safe ? PARALLEL_LOOPS : SERIAL_LOOPS) + (obj->low_priority ? LOW_SERIAL_LOOPS : 0);
+    if (obj->loop_slot >= 0 && (!wanted || obj->loop_list != list || obj->loop_group != obj->loop_interval))
+        removeLoop(obj);
+    if (wanted && obj->loop_slot < 0)
+    {
+        auto &group = loops[list][obj->loop_interval];
+        obj->loop_slot = group.size();
+        obj->loop_list = list;
+        obj->loop_group = obj->loop_interval;
+        obj->last_loop = -1;
+        group.push_back(obj);
+    }
+}
+
+void Engine::refreshActive(Object *obj)
+{
+    if (ticking)
+    {
+        record({EngineCommand::REFRESH_ACTIVE, obj->shared_from_this(), nullptr});
+        return;
+    }
+    if (obj->engine_active == obj->active || obj->engine_ptr != this)
+        return; // already applied, several commands for the same object are recorded on a flip and back
+    obj->engine_active = obj->active;
+    refreshLoop(obj);
+    // the body and the graphics registration are kept, so that pooled objects are not rebuilt
+    auto physics = dynamic_cast<PhysicsObject *>(obj);
+    if (physics && physics->body)
+        physics->body->SetEnabled(obj->active);
+    for (auto &handle : obj->handlers)
+    {
+        if (obj->active)
+            disp->registerEventHandler(handle);
+        else
+            disp->unregisterEventHandler(handle);
+    }
+    if (obj->active)
+        startBehaviours(obj);
+    else
+    {
+        obj->timer_owner = make_shared<char>(); // drops the object's timers, and behaviours about to start
+        obj->behaviours.clear();
+        obj->behaviours_pending = false;
+    }
+}
+
+void Engine::startBehaviours(Object *obj)
+{
+    // behaviours run inside ticks only, where the changes they make are deferred
+    if (obj->behaviour_factories.empty())
+    {
+        obj->behaviours_pending = false;
+        return;
+    }
+    obj->behaviours_pending = true;
+    onNextTick(obj->timer_owner, [obj]()
+    {
+        for (auto &factory : obj->behaviour_factories)
+            obj->runBehaviour(factory); // behaviours attached meanwhile are reached by the loop too
+        obj->behaviours_pending = false;
+    });
+}
+
+void Engine::removeLoop(Object *obj)
+{
+    if (obj->loop_slot < 0)
+        return;
+    auto &list = loops[obj->loop_list][obj->loop_group];
+    Object *last = list.back();
+    list[obj->loop_slot] = last;
+    last->loop_slot = obj->loop_slot;
+    list.pop_back();
+    obj->loop_slot = -1;
+}
+
+void Engine::record(EngineCommand command)
+{
+    if (JobSystem::currentPool() == workers.get())
+        command_buffers[JobSystem::currentWorker() + 1].push_back(std::move(command));
+    else if (std::this_thread::get_id() == tick_thread)
+        command_buffers[0].push_back(std::move(command));
+    else
+    {
+        std::lock_guard<mutex> lock(foreign_m);
+        foreign_commands.push_back(std::move(command));
+    }
+}
+
+void Engine::applyCommands()
+{
+    PROFILE_ZONE("Engine::applyCommands");
+    for (auto &buffer : command_buffers)
+    {
+        std::move(buffer.begin(), buffer.end(), std::back_inserter(applying));
+        buffer.clear();
+    }
+    {
+        std::lock_guard<mutex> lock(foreign_m);
+        std::move(foreign_commands.begin(), foreign_commands.end(), std::back_inserter(applying));
+        foreign_commands.clear();
+    }
+    if (applying.empty())
+        return;
+    for (size_t i = 0; i < applying.size(); i++)
+    {
+        auto type = applying[i].type;
+        if (type == EngineCommand::REGISTER || type == EngineCommand::UNREGISTER)
+            last_change[applying[i].obj.get()] = i;
+    }
+    for (size_t i = 0; i < applying.size(); i++)
+    {
+        EngineCommand &command = applying[i];
+        switch (command.type)
+        {
+        case EngineCommand::REGISTER:
+            if (last_change[command.obj.get()] == i)
+                registerNow(command.obj);
+            break;
+        case EngineCommand::UNREGISTER:
+            if (last_change[command.obj.get()] == i)
+                unregisterNow(command.obj);
+            break;
+        case EngineCommand::REFRESH_LOOP:
+            refreshLoop(command.obj.get());
+            break;
+        case EngineCommand::REFRESH_ACTIVE:
+            refreshActive(command.obj.get());
+            break;
+        case EngineCommand::REGISTER_HANDLER:
+            disp->registerEventHandler(command.handle);
+            break;
+        case EngineCommand::UNREGISTER_HANDLER:
+            disp->unregisterEventHandler(command.handle);
+            break;
+        }
+    }
+    applying.clear();
+    last_change.clear();
 }
 
 void Engine::registerObj(shared_ptr<Object> obj)
 {
-    obj->engine_view = weak_from_this();
+    if (ticking)
+    {
+        claimTree(obj.get(), this);
+        record({EngineCommand::REGISTER, obj, nullptr});
+    }
+    else
+        registerNow(obj);
+}
+
+void Engine::unregisterObj(shared_ptr<Object> obj)
+{
+    if (ticking)
+    {
+        // detached right away, so children added to it later in the tick are not registered
+        claimTree(obj.get(), nullptr);
+        record({EngineCommand::UNREGISTER, obj, nullptr});
+    }
+    else
+        unregisterNow(obj);
+}
+
+void Engine::claimTree(Object *obj, Engine *engine)
+{
+    if (obj->engine_ptr != nullptr && obj->engine_ptr != this)
+        return;
+    obj->engine_ptr = engine;
+    for (auto &child : obj->children)
+        claimTree(child.get(), engine);
+}
+
+void Engine::registerHandler(shared_ptr<HandlerI> handle)
+{
+    if (ticking)
+        record({EngineCommand::REGISTER_HANDLER, nullptr, handle});
+    else
+        disp->registerEventHandler(handle);
+}
+
+void Engine::unregisterHandler(shared_ptr<HandlerI> handle)
+{
+    if (ticking)
+        record({EngineCommand::UNREGISTER_HANDLER, nullptr, handle});
+    else
+        disp->unregisterEventHandler(handle);
+}
+
+void Engine::registerNow(shared_ptr<Object> obj)
+{
+    if (bucket.count(obj))
+    {
+        obj->engine_ptr = this; // may have been cleared by a skipped unregister
+        return;
+    }
+    obj->engine_ptr = this;
+    obj->timer_owner = make_shared<char>();
+    obj->behaviours_pending = true;
+    obj->engine_active = true; // registered as active, then deactivated below if it is not
     obj->init();
     bucket.insert(obj);
+    refreshLoop(obj.get());
+    auto object2d = dynamic_cast<Object2D *>(obj.get());
+    if (object2d)
+        transforms->add(object2d);
     shared_ptr<GraphicObject> graphic = dynamic_pointer_cast<GraphicObject>(obj);
     if (graphic)
     {
@@ -98,19 +852,28 @@ void Engine::registerObj(shared_ptr<Object> obj)
     }
     for (auto &iter : obj->children)
     {
-        registerObj(iter);
+        registerNow(iter);
     }
+    startBehaviours(obj.get());
+    if (!obj->active)
+        refreshActive(obj.get());
 }
 
-void Engine::unregisterObj(shared_ptr<Object> obj)
+void Engine::unregisterNow(shared_ptr<Object> obj)
 {
-    for (auto iter = obj->children.begin(); iter != obj->children.end(); iter++)
+    for (auto &child : obj->children)
     {
-        unregisterObj(*iter);
+        unregisterNow(child);
     }
+    if (obj->engine_ptr == this)
+        obj->engine_ptr = nullptr;
+    if (!bucket.count(obj))
+        return; // never registered, only recorded during a tick
+    obj->timer_owner.reset(); // drops the object's timers
+    obj->behaviours.clear();
     for (auto handle : obj->handlers)
     {
-        disp->registerEventHandler(handle);
+        disp->unregisterEventHandler(handle);
     }
     shared_ptr<GraphicObject> graphic = dynamic_pointer_cast<GraphicObject>(obj);
     if (graphic)
@@ -122,29 +885,69 @@ void Engine::unregisterObj(shared_ptr<Object> obj)
     {
         world->unregisterObj(physics);
     }
-    
-    obj->engine_view.reset();
-    dead_bucket.emplace(obj);
+    removeLoop(obj.get());
+    auto object2d = dynamic_cast<Object2D *>(obj.get());
+    if (object2d)
+        transforms->remove(object2d);
+    bucket.erase(obj);
+}
+
+void Engine::onNextTick(weak_ptr<void> owner, function<void()> callback)
+{
+    next_tick.push_back({std::move(owner), std::move(callback)});
 }
 
 void Engine::update(double delta)
 {
-    // loops
-    for (auto iter = bucket.begin(); iter != bucket.end(); iter++)
+    PROFILE_ZONE("Engine::update");
+    // loops, changes they make to the scene are applied by tick() once they are done
+    // by tick count alone, so that the same objects loop on the same ticks in every run
+    auto strided = [](size_t size, size_t first, size_t stride)
     {
-        (*iter)->loop(delta);
-    }
+        return size > first ? (size - first + stride - 1) / stride : 0;
+    };
+    size_t shed = load.overloaded && config.low_priority_stride > 1 ? config.low_priority_stride : 1;
+    for (LoopList list : {SERIAL_LOOPS, PARALLEL_LOOPS, LOW_SERIAL_LOOPS, LOW_PARALLEL_LOOPS})
+        for (auto &[interval, objects] : loops[list])
+        {
+            size_t stride = interval;
+            if (list == LOW_SERIAL_LOOPS || list == LOW_PARALLEL_LOOPS)
+                stride *= shed;
+            size_t first = tick_count % stride;
+            runLoops(list, objects, first, stride, delta);
+            load.throttled_loops += strided(objects.size(), tick_count % interval, interval) - strided(objects.size(), first, stride);
+        }
 }
 
-void EngineController::loop(double delta)
+void Engine::runLoops(LoopList list, vector<Object *> &objects, size_t first, size_t stride, double delta)
 {
-    double time = timeout.get_time();
-    std::cout << string() + "Time: " + std::to_string(time) + "\n";
-    if (time > 120)
+    bool catch_up = stride > 1 || list == LOW_SERIAL_LOOPS || list == LOW_PARALLEL_LOOPS;
+    auto loop_one = [this, &objects, first, stride, delta, catch_up](size_t i)
     {
-        auto shared_engine = engine_view.lock();
-        if (!shared_engine)
+        PROFILE_OBJECT_ZONE("Object::loop");
+        Object *obj = objects[first + i * stride];
+        if (!catch_up)
+        {
+            obj->loop(delta);
             return;
-        shared_engine->is_stopped = true;
-    }
+        }
+        double elapsed = obj->last_loop >= 0 ? clock->now() - obj->last_loop : delta;
+        obj->last_loop = clock->now();
+        obj->loop(elapsed);
+    };
+    size_t count = objects.size() > first ? (objects.size() - first + stride - 1) / stride : 0;
+    if (list == SERIAL_LOOPS || list == LOW_SERIAL_LOOPS)
+        for (size_t i = 0; i < count; i++)
+            loop_one(i);
+    else
+        workers->parallelFor(0, count, 64, [&loop_one](size_t i)
+        {
+            struct Depth
+            {
+                Depth() { parallel_depth++; }
+                ~Depth() { parallel_depth--; }
+            } depth;
+            loop_one(i);
+        });
 }
+
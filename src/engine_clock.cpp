@@ -0,0 +1,26 @@
+/**
+ * @file engine_clock.cpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <engine_clock.hpp>
+
+double EngineClock::frame(double real_delta, double tick_delta)
+{
+    real_time += real_delta;
+    if (paused)
+        return 0;
+    return (virtual_time ? tick_delta : real_delta) * scale;
+}
+
+void EngineClock::setScale(double scale)
+{
+    if (scale < 0)
+        throw std::out_of_range("Time scale can not be negative");
+    this->scale = scale;
+}
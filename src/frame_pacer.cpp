@@ -0,0 +1,127 @@
+/**
+ * @file frame_pacer.cpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <frame_pacer.hpp>
+#include <profiler.hpp>
+
+FramePacer::FramePacer(double rate, double low_power_rate)
+{
+    period = rate > 0 ? 1.0 / rate : 0;
+    low_power_period = low_power_rate > 0 ? 1.0 / low_power_rate : period;
+}
+
+void FramePacer::setRate(double rate)
+{
+    period = rate > 0 ? 1.0 / rate : 0;
+    reset();
+}
+
+void FramePacer::setLowPower(bool low_power)
+{
+    this->low_power = low_power;
+    reset();
+}
+
+void FramePacer::setIdle(function<void()> idle, double interval)
+{
+    this->idle = idle;
+    idle_interval = interval;
+}
+
+void FramePacer::reset()
+{
+    started = false;
+}
+
+double FramePacer::wait()
+{
+    PROFILE_ZONE("FramePacer::wait");
+    double frame_period = low_power ? low_power_period : period;
+    auto now = steady_clock::now();
+    if (!started)
+    {
+        started = true;
+        last = now;
+        deadline = now;
+    }
+    deadline += std::chrono::duration_cast<steady_clock::duration>(std::chrono::duration<double>(frame_period));
+    // more than a frame behind, start over from now instead of rushing a burst of frames
+    if (now - deadline > std::chrono::duration<double>(frame_period))
+        deadline = now;
+
+    double spin_window = low_power ? 0 : std::max(min_spin, oversleep * 1.5);
+    double remaining = seconds(deadline - now);
+    double overshoot = -1;
+    if (remaining > spin_window)
+    {
+        auto wake = deadline - std::chrono::duration_cast<steady_clock::duration>(std::chrono::duration<double>(spin_window));
+        if (idle)
+        {
+            auto chunk = std::chrono::duration_cast<steady_clock::duration>(std::chrono::duration<double>(idle_interval));
+            while (now + chunk < wake)
+            {
+                idle();
+                std::this_thread::sleep_until(now + chunk);
+                now = steady_clock::now();
+            }
+            idle();
+        }
+        std::this_thread::sleep_until(wake);
+        now = steady_clock::now();
+        overshoot = std::max(0.0, seconds(now - wake));
+    }
+    auto spin_begin = now;
+    while (now < deadline && !low_power)
+        now = steady_clock::now();
+    double spun = seconds(now - spin_begin);
+
+    double interval = seconds(now - last);
+    last = now;
+    std::lock_guard<mutex> lock(stats_m);
+    if (overshoot >= 0)
+    {
+        // quick to grow and slow to decay, a late frame costs more than a little extra spinning
+        double weight = overshoot > oversleep ? 0.25 : 0.02;
+        oversleep += (overshoot - oversleep) * weight;
+        oversleep = std::min(oversleep, frame_period);
+    }
+    frames++;
+    sum += interval;
+    sum_squares += interval * interval;
+    worst = std::max(worst, std::abs(interval - frame_period));
+    spin_total += spun;
+    if (interval > frame_period * 1.5 && frame_period > 0)
+        late++;
+    return interval;
+}
+
+PacerStats FramePacer::getStats()
+{
+    std::lock_guard<mutex> lock(stats_m);
+    PacerStats stats;
+    stats.frames = frames;
+    if (frames == 0)
+        return stats;
+    double mean = sum / frames;
+    stats.mean = mean * 1000;
+    stats.jitter = std::sqrt(std::max(0.0, sum_squares / frames - mean * mean)) * 1000;
+    stats.worst = worst * 1000;
+    stats.late = late;
+    stats.oversleep = oversleep * 1000;
+    stats.spin = spin_total / frames * 1000;
+    return stats;
+}
+
+void FramePacer::resetStats()
+{
+    std::lock_guard<mutex> lock(stats_m);
+    frames = late = 0;
+    sum = sum_squares = worst = spin_total = 0;
+}
@@ -1,15 +1,18 @@
 #include <graphic_system.hpp>
 #include <colors.h>
 #include <objects.hpp>
+#include <profiler.hpp>
 
 class GraphicObject;
 
-GraphicSystem::GraphicSystem(Vect2i window_size)
+GraphicSystem::GraphicSystem(Vect2i window_size, bool headless, bool vsync)
 {
     camera_pos = window_size / 2;
     this->window_size = window_size;
+    if (headless)
+        return;
     window = SDL_CreateWindow("Window Name", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, window_size.x, window_size.y, SDL_WINDOW_SHOWN);
-    render = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    render = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | (vsync ? SDL_RENDERER_PRESENTVSYNC : 0));
 }
 
 shared_ptr<Texture> GraphicSystem::loadTexture(string filepath)
@@ -23,6 +26,7 @@ void GraphicSystem::registerObj(shared_ptr<GraphicObject> obj)
 {
     obj->render_view = render;
     obj->gsys_view = this;
+    obj->has_previous = false; // nothing to interpolate from until the next snapshot
     bucket.emplace(obj->z, obj);
 }
 
@@ -34,15 +38,94 @@ void GraphicSystem::unregisterObj(shared_ptr<GraphicObject> obj)
     bucket.erase({obj->z, obj});
 }
 
-void GraphicSystem::update()
+void GraphicSystem::snapshot()
 {
+    for (auto &entry : bucket)
+    {
+        GraphicObject &obj = *entry.second.get();
+        obj.previous_position = transforms->position(&obj);
+        obj.has_previous = true;
+    }
+}
+
+void GraphicSystem::update(float alpha)
+{
+    PROFILE_ZONE("GraphicSystem::update");
+    this->alpha = alpha;
+    if (render == nullptr)
+        return;
     SDL_SetRenderDrawColor(render, RGB_WHITE, 255);
     SDL_RenderClear(render);
     for (auto iter = bucket.begin(); iter != bucket.end(); iter++)
     {
         GraphicObject &obj = *iter->second.get();
-        // workers->enqueue(std::bind(&GraphicObject::draw, iter->second.get()));
+        if (!obj.isActive())
+            continue;
+        // draws stay on this thread, SDL renderers are not thread safe
+        PROFILE_OBJECT_ZONE("GraphicObject::draw");
         obj.draw();
     }
     SDL_RenderPresent(render);
 }
+
+void GraphicSystem::record(DrawList &list, float alpha)
+{
+    PROFILE_ZONE("GraphicSystem::record");
+    this->alpha = alpha;
+    list.clear();
+    for (auto iter = bucket.begin(); iter != bucket.end(); iter++)
+        if (iter->second->isActive())
+            iter->second->record(list);
+}
+
+void GraphicSystem::submit(const DrawList &list)
+{
+    PROFILE_ZONE("GraphicSystem::submit");
+    if (render == nullptr)
+        return;
+    SDL_SetRenderDrawColor(render, RGB_WHITE, 255);
+    SDL_RenderClear(render);
+    for (const DrawCommand &command : list)
+    {
+        if (SDL_RenderCopyEx(render, command.atlas->texture, &command.src, &command.dest, 0, NULL, SDL_FLIP_NONE))
+            std::cout << SDL_GetError() << '\n';
+    }
+    SDL_RenderPresent(render);
+}
+
+bool FramePipeline::publish()
+{
+    std::unique_lock<mutex> lock(m);
+    changed.wait(lock, [this]() { return (!frame_ready && !reading) || stopped; });
+    if (stopped)
+        return false;
+    write_index = 1 - write_index;
+    frame_ready = true;
+    changed.notify_all();
+    return true;
+}
+
+const DrawList *FramePipeline::acquire(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<mutex> lock(m);
+    if (!changed.wait_for(lock, timeout, [this]() { return frame_ready || stopped; }) || stopped)
+        return nullptr;
+    frame_ready = false;
+    reading = true;
+    return &buffers[1 - write_index];
+}
+
+void FramePipeline::release()
+{
+    std::lock_guard<mutex> lock(m);
+    buffers[1 - write_index].clear();
+    reading = false;
+    changed.notify_all();
+}
+
+void FramePipeline::stop()
+{
+    std::lock_guard<mutex> lock(m);
+    stopped = true;
+    changed.notify_all();
+}
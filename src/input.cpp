@@ -0,0 +1,120 @@
+/**
+ * @file input.cpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <input.hpp>
+#include <profiler.hpp>
+
+#include <algorithm>
+
+void InputSystem::pump()
+{
+    PROFILE_ZONE("InputSystem::pump");
+    SDL_PumpEvents();
+    SDL_Event events[32];
+    int count;
+    while ((count = SDL_PeepEvents(events, 32, SDL_GETEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT)) > 0)
+    {
+        auto now = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; i++)
+            pending.push_back({events[i], now});
+    }
+}
+
+vector<InputSample> InputSystem::take(unsigned long tick, bool measured)
+{
+    pump();
+    vector<InputSample> taken;
+    taken.swap(pending);
+    for (auto &sample : taken)
+    {
+        sample.tick = tick;
+        if (measured && !sample.latched) // latched ones were measured at the frame they were latched for
+            in_flight.push_back(sample);
+    }
+    return taken;
+}
+
+void InputSystem::addLatch(weak_ptr<void> owner, function<void(const InputState &)> callback)
+{
+    latches.emplace_back(std::move(owner), std::move(callback));
+}
+
+void InputSystem::latch()
+{
+    PROFILE_ZONE("InputSystem::latch");
+    pump();
+    std::erase_if(latches, [](auto &latch)
+                  {
+        const weak_ptr<void> none;
+        bool owned = latch.first.owner_before(none) || none.owner_before(latch.first);
+        return owned && latch.first.expired(); });
+    if (latches.empty())
+        return;
+    InputState state;
+    state.buttons = SDL_GetMouseState(&state.mouse.x, &state.mouse.y);
+    state.keys = SDL_GetKeyboardState(&state.key_count);
+    for (size_t i = 0; i < latches.size(); i++)
+        latches[i].second(state);
+    for (auto &sample : pending)
+        if (!sample.latched)
+        {
+            sample.latched = true;
+            latched_arrivals.push_back(sample.arrival);
+        }
+}
+
+void InputSystem::presented(unsigned long tick)
+{
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<mutex> lock(stats_m);
+    for (auto arrival : latched_arrivals)
+        measure(arrival, now);
+    latched_arrivals.clear();
+    std::erase_if(in_flight, [&](const InputSample &sample)
+                  {
+        if (sample.tick >= tick)
+            return false;
+        measure(sample.arrival, now);
+        return true; });
+}
+
+void InputSystem::measure(std::chrono::steady_clock::time_point arrival, std::chrono::steady_clock::time_point present)
+{
+    double latency = std::chrono::duration<double, std::milli>(present - arrival).count();
+    if (latencies.size() < latency_window)
+        latencies.push_back(latency);
+    else
+        latencies[latency_next] = latency;
+    latency_next = (latency_next + 1) % latency_window;
+    latency_count++;
+}
+
+LatencyStats InputSystem::getLatency()
+{
+    vector<double> sorted;
+    LatencyStats stats;
+    {
+        std::lock_guard<mutex> lock(stats_m);
+        sorted = latencies;
+        stats.samples = latency_count;
+    }
+    if (sorted.empty())
+        return stats;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&](double p)
+    {
+        return sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))];
+    };
+    stats.p50 = percentile(0.5);
+    stats.p90 = percentile(0.9);
+    stats.p99 = percentile(0.99);
+    stats.max = sorted.back();
+    return stats;
+}
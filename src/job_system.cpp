@@ -0,0 +1,144 @@
+/**
+ * @file job_system.cpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <job_system.hpp>
+
+namespace
+{
+    thread_local int worker_index = -1;
+    thread_local JobSystem *worker_pool = nullptr;
+}
+
+JobSystem::JobSystem(int worker_count)
+{
+    if (worker_count < 0)
+    {
+        int cores = std::thread::hardware_concurrency();
+        worker_count = cores > 1 ? cores - 1 : 0;
+    }
+    stopping = false;
+    queued = 0;
+    next_queue = 0;
+    // the last queue takes submits from threads outside the pool
+    for (int i = 0; i < worker_count + 1; i++)
+        queues.push_back(make_unique<Queue>());
+    for (int i = 0; i < worker_count; i++)
+        threads.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    stopping = true;
+    wake.notify_all();
+    for (auto &thread : threads)
+        thread.join();
+}
+
+int JobSystem::currentWorker()
+{
+    return worker_index;
+}
+
+JobSystem *JobSystem::currentPool()
+{
+    return worker_pool;
+}
+
+void JobSystem::workerLoop(int index)
+{
+    worker_index = index;
+    worker_pool = this;
+    while (!stopping)
+    {
+        if (runOne(index))
+            continue;
+        std::unique_lock<mutex> lock(sleep_m);
+        // the timeout covers a submit landing between the check and the wait
+        wake.wait_for(lock, std::chrono::milliseconds(1), [this]() { return queued > 0 || stopping; });
+    }
+}
+
+bool JobSystem::runOne(int index)
+{
+    if (queued == 0)
+        return false;
+    Job job;
+    bool found = false;
+    {
+        Queue &own = *queues[index];
+        std::lock_guard<mutex> lock(own.m);
+        if (!own.jobs.empty())
+        {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            found = true;
+        }
+    }
+    for (size_t i = 1; !found && i < queues.size(); i++)
+    {
+        Queue &victim = *queues[(index + i) % queues.size()];
+        std::lock_guard<mutex> lock(victim.m);
+        if (!victim.jobs.empty())
+        {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            found = true;
+        }
+    }
+    if (!found)
+        return false;
+    queued--;
+    if (job.group == nullptr)
+    {
+        job.fn();
+        return true;
+    }
+    try
+    {
+        job.fn();
+    }
+    catch (...)
+    {
+        std::lock_guard<mutex> lock(job.group->error_m);
+        if (!job.group->error)
+            job.group->error = std::current_exception();
+    }
+    job.group->remaining--; // last, the group may be gone right after
+    return true;
+}
+
+void JobSystem::submit(function<void()> job, TaskGroup *group)
+{
+    if (group != nullptr)
+        group->remaining++;
+    int index = worker_pool == this ? worker_index : -1;
+    if (index < 0)
+    {
+        // spread outside submits over the workers, they will steal from each other anyway
+        index = threads.empty() ? queues.size() - 1 : next_queue++ % threads.size();
+    }
+    {
+        Queue &queue = *queues[index];
+        std::lock_guard<mutex> lock(queue.m);
+        queue.jobs.push_back({std::move(job), group});
+    }
+    queued++;
+    wake.notify_one();
+}
+
+void JobSystem::wait(TaskGroup &group)
+{
+    int index = worker_pool == this ? worker_index : queues.size() - 1;
+    while (group.remaining > 0)
+    {
+        if (!runOne(index))
+            std::this_thread::yield();
+    }
+}
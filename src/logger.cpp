@@ -0,0 +1,172 @@
+/**
+ * @file logger.cpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <logger.hpp>
+
+bool LogRing::push(const LogRecord &record)
+{
+    size_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) == capacity)
+    {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    records[h & (capacity - 1)] = record;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+bool LogRing::pop(LogRecord &record)
+{
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire))
+        return false;
+    record = records[t & (capacity - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+bool LogRing::empty() const
+{
+    return tail.load(std::memory_order_acquire) == head.load(std::memory_order_acquire);
+}
+
+Logger::Logger()
+{
+    start_time = std::chrono::steady_clock::now();
+    out = &std::cout;
+    stopping = false;
+    drain_thread = std::thread([this]()
+    {
+        while (!stopping)
+        {
+            if (!drain())
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        drain(); // whatever was logged while stopping
+    });
+}
+
+Logger &Logger::instance()
+{
+    static Logger logger;
+    return logger;
+}
+
+Logger::~Logger()
+{
+    stopping = true;
+    drain_thread.join();
+    out->flush();
+}
+
+LogRing &Logger::localRing()
+{
+    thread_local shared_ptr<LogRing> ring;
+    if (!ring)
+    {
+        ring = make_shared<LogRing>();
+        std::lock_guard<mutex> lock(rings_m);
+        rings.push_back(ring);
+    }
+    return *ring;
+}
+
+bool Logger::drain()
+{
+    bool wrote = false;
+    std::lock_guard<mutex> lock(rings_m);
+    for (auto iter = rings.begin(); iter != rings.end();)
+    {
+        LogRecord record;
+        while ((*iter)->pop(record))
+        {
+            write(record);
+            wrote = true;
+        }
+        // the logger holds the last reference once the owning thread has exited
+        if (iter->use_count() == 1 && (*iter)->empty())
+            iter = rings.erase(iter);
+        else
+            iter++;
+    }
+    if (wrote)
+        out->flush();
+    return wrote;
+}
+
+void Logger::write(const LogRecord &record)
+{
+    static const char *level_names[] = {"TRACE", "DEBUG", "INFO ", "WARN ", "ERROR"};
+    char stamp[32];
+    std::snprintf(stamp, sizeof(stamp), "[%12.6f] ", record.timestamp / 1e9);
+    *out << stamp << level_names[record.level < LOG_LEVEL_OFF ? record.level : LOG_LEVEL_ERROR] << ' ';
+    int arg = 0;
+    for (const char *c = record.format; *c != '\0'; c++)
+    {
+        if (c[0] == '{' && c[1] == '}' && arg < record.arg_count)
+        {
+            const LogArg &value = record.args[arg++];
+            switch (value.type)
+            {
+            case LogArg::INT:
+                *out << value.i;
+                break;
+            case LogArg::UINT:
+                *out << value.u;
+                break;
+            case LogArg::DOUBLE:
+                *out << value.d;
+                break;
+            case LogArg::STR:
+                *out << (value.s ? value.s : "(null)");
+                break;
+            }
+            c++;
+        }
+        else
+            *out << *c;
+    }
+    *out << '\n';
+}
+
+void Logger::setOutput(std::ostream &out)
+{
+    std::lock_guard<mutex> lock(rings_m);
+    this->out = &out;
+}
+
+void Logger::flush()
+{
+    while (true)
+    {
+        {
+            std::lock_guard<mutex> lock(rings_m);
+            bool empty = true;
+            for (auto &ring : rings)
+                empty = empty && ring->empty();
+            if (empty)
+                break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // the last records may have been popped but not yet printed
+    std::lock_guard<mutex> lock(rings_m);
+    out->flush();
+}
+
+uint64_t Logger::droppedCount()
+{
+    std::lock_guard<mutex> lock(rings_m);
+    uint64_t total = 0;
+    for (auto &ring : rings)
+        total += ring->dropped;
+    return total;
+}
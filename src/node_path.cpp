@@ -0,0 +1,86 @@
+/**
+ * @file node_path.cpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <node_path.hpp>
+#include <objects.hpp>
+
+NodePath::NodePath(std::string_view path)
+{
+    size_t begin = 0;
+    while (true)
+    {
+        size_t delim = path.find('/', begin);
+        segments.emplace_back(path.substr(begin, delim - begin));
+        if (delim == string::npos)
+            break;
+        begin = delim + 1;
+    }
+}
+
+string NodePath::str() const
+{
+    string text;
+    for (size_t i = 0; i < segments.size(); i++)
+    {
+        if (i > 0)
+            text += '/';
+        text += segments[i].str();
+    }
+    return text;
+}
+
+shared_ptr<Object> NodePath::resolve(Object *root) const
+{
+    // stamps are unique over all objects ever made, so an unchanged one means the very same node with the same children
+    if (target != nullptr && visited.front().first == root)
+    {
+        bool valid = true;
+        for (auto &[node, stamp] : visited)
+            valid = valid && node->structure_stamp == stamp;
+        if (valid)
+            return target->shared_from_this();
+    }
+    target = nullptr;
+    visited.clear();
+    Object *node = root;
+    for (auto &segment : segments)
+    {
+        auto it = node->children_map.find(segment);
+        if (it == node->children_map.end())
+        {
+            visited.clear();
+            throw std::out_of_range("Child " + segment.str() + " not found");
+        }
+        visited.emplace_back(node, node->structure_stamp);
+        node = it->second.get();
+    }
+    target = node;
+    return target->shared_from_this();
+}
+
+shared_ptr<Object> NodePath::find(Object *root, std::string_view path)
+{
+    Object *node = root;
+    size_t begin = 0;
+    while (true)
+    {
+        size_t delim = path.find('/', begin);
+        std::string_view segment = path.substr(begin, delim - begin);
+        auto atom = Atom::find(segment);
+        auto it = atom ? node->children_map.find(*atom) : node->children_map.end();
+        if (it == node->children_map.end())
+            throw std::out_of_range("Child " + string(segment) + " not found");
+        node = it->second.get();
+        if (delim == string::npos)
+            break;
+        begin = delim + 1;
+    }
+    return node->shared_from_this();
+}
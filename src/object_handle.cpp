@@ -0,0 +1,116 @@
+/**
+ * @file object_handle.cpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <object_handle.hpp>
+#include <objects.hpp>
+
+ObjectTable::Slot *ObjectTable::chunks[ObjectTable::max_chunks] = {};
+
+namespace
+{
+    const size_t batch = 64; // slots moved between a thread's own free list and the shared one at a time
+
+    mutex table_mutex; // taken once per batch, not for every object
+    vector<uint32_t> free_slots;
+    uint32_t next_slot = 1; // slot 0 stands for the null handle
+
+    // slots a thread made and destroyed objects with, so that engines on different threads do not contend
+    struct LocalSlots
+    {
+        vector<uint32_t> free;
+        ~LocalSlots();
+    };
+    thread_local LocalSlots local_slots;
+    thread_local bool local_gone = false; // past the destruction of local_slots, at the end of the thread
+
+    LocalSlots::~LocalSlots()
+    {
+        local_gone = true;
+        std::lock_guard<mutex> lock(table_mutex);
+        free_slots.insert(free_slots.end(), free.begin(), free.end());
+    }
+}
+
+void ObjectTable::refill(vector<uint32_t> &into, size_t count)
+{
+    std::lock_guard<mutex> lock(table_mutex);
+    while (count > 0 && !free_slots.empty())
+    {
+        into.push_back(free_slots.back());
+        free_slots.pop_back();
+        count--;
+    }
+    for (; count > 0; count--)
+    {
+        if (next_slot == max_chunks * chunk_size)
+        {
+            if (into.empty())
+                throw std::runtime_error("Too many live objects");
+            return;
+        }
+        if (chunks[next_slot >> chunk_bits] == nullptr)
+            chunks[next_slot >> chunk_bits] = new Slot[chunk_size]; // never freed, handles may outlive everything else
+        into.push_back(next_slot++);
+    }
+}
+
+ObjectHandle ObjectTable::allocate(Object *obj)
+{
+    uint32_t index;
+    if (local_gone)
+    {
+        vector<uint32_t> one;
+        refill(one, 1);
+        index = one.back();
+    }
+    else
+    {
+        vector<uint32_t> &free = local_slots.free;
+        if (free.empty())
+            refill(free, batch);
+        index = free.back();
+        free.pop_back();
+    }
+    Slot &entry = slot(index);
+    entry.object = obj;
+    ObjectHandle handle;
+    handle.index = index;
+    handle.generation = entry.generation;
+    return handle;
+}
+
+void ObjectTable::release(ObjectHandle handle)
+{
+    if (handle.index == 0)
+        return;
+    Slot &entry = slot(handle.index);
+    entry.object = nullptr;
+    entry.generation++;
+    if (local_gone)
+    {
+        std::lock_guard<mutex> lock(table_mutex);
+        free_slots.push_back(handle.index);
+        return;
+    }
+    vector<uint32_t> &free = local_slots.free;
+    free.push_back(handle.index);
+    if (free.size() < 2 * batch)
+        return;
+    // hand a batch back, for threads which make more objects than they destroy
+    std::lock_guard<mutex> lock(table_mutex);
+    free_slots.insert(free_slots.end(), free.end() - batch, free.end());
+    free.resize(free.size() - batch);
+}
+
+shared_ptr<Object> ObjectHandle::lock() const
+{
+    Object *obj = get();
+    return obj != nullptr ? obj->weak_from_this().lock() : nullptr;
+}
@@ -9,14 +9,46 @@
 
 #include <objects.hpp>
 
+#include <charconv>
+
 #include <engine.hpp>
 #include <graphic_system.hpp>
 #include <events.hpp>
 #include <dispatcher.hpp>
+#include <job_system.hpp>
+
+namespace
+{
+    std::atomic<uint64_t> next_structure_stamp{1};
+}
 
-Object::Object(string desiredName)
+Object::Object(Atom desiredName)
 {
     this->desiredName = desiredName;
+    structure_stamp = next_structure_stamp++;
+    self_handle = ObjectTable::allocate(this);
+}
+
+Object::Object(const Object &other)
+    : enable_shared_from_this(other),
+      init_behavior(other.init_behavior),
+      loop_behavior(other.loop_behavior),
+      thread_safe(other.thread_safe),
+      low_priority(other.low_priority),
+      loop_interval(other.loop_interval),
+      behaviour_factories(other.behaviour_factories),
+      active(other.active),
+      desiredName(other.desiredName)
+{
+    structure_stamp = next_structure_stamp++;
+    self_handle = ObjectTable::allocate(this);
+}
+
+Object::~Object()
+{
+    ObjectTable::release(self_handle); // first, so that the children see no parent
+    for (auto &child : children)
+        child->parentChanged(true); // children held elsewhere lose their parent
 }
 
 void Object::init()
@@ -31,71 +63,248 @@ void Object::loop(double delta)
         loop_behavior(this, delta);
 }
 
+void Object::setThreadSafe(bool thread_safe)
+{
+    this->thread_safe = thread_safe;
+    Engine *engine = engine_ptr;
+    if (engine)
+        engine->refreshLoop(this);
+}
+
+bool Object::isThreadSafe()
+{
+    return thread_safe;
+}
+
+void Object::setLowPriority(bool low_priority)
+{
+    this->low_priority = low_priority;
+    Engine *engine = engine_ptr;
+    if (engine)
+        engine->refreshLoop(this);
+}
+
+bool Object::isLowPriority()
+{
+    return low_priority;
+}
+
+void Object::setLoopInterval(int ticks)
+{
+    if (ticks < 1)
+        throw std::out_of_range("Loop interval must be at least one tick");
+    loop_interval = ticks;
+    Engine *engine = engine_ptr;
+    if (engine)
+        engine->refreshLoop(this);
+}
+
+int Object::getLoopInterval()
+{
+    return loop_interval;
+}
+
 shared_ptr<Engine> Object::getEngine()
 {
-    //if(!engine_view.lock())
+    //if(!engine_ptr)
     //    throw std::runtime_error("Object not owned by engine");
-    return engine_view.lock();
+    return engine_ptr != nullptr ? engine_ptr->weak_from_this().lock() : nullptr;
+}
+
+TimerId Object::after(double seconds, function<void()> callback)
+{
+    Engine *engine = engine_ptr;
+    if (!engine || !timer_owner)
+        throw std::runtime_error("Object not registered in an engine");
+    if (Engine::parallel_depth > 0) // a serial tick may run on a pool worker too, under Engine::stepAll
+        throw std::runtime_error("Timers can not be set from parallel loops");
+    return engine->timers->schedule(seconds, std::move(callback), timer_owner);
+}
+
+TimerId Object::every(double period, function<void()> callback)
+{
+    Engine *engine = engine_ptr;
+    if (!engine || !timer_owner)
+        throw std::runtime_error("Object not registered in an engine");
+    if (Engine::parallel_depth > 0)
+        throw std::runtime_error("Timers can not be set from parallel loops");
+    return engine->timers->repeat(period, std::move(callback), timer_owner);
+}
+
+bool Object::cancelTimer(TimerId id)
+{
+    Engine *engine = engine_ptr;
+    if (!engine)
+        return false;
+    return engine->timers->cancel(id);
+}
+
+void Object::attachBehaviour(function<Behaviour(Object *)> behaviour)
+{
+    behaviour_factories.push_back(behaviour);
+    Engine *engine = engine_ptr;
+    if (!engine || !timer_owner || behaviours_pending)
+        return; // started on registration
+    auto *factory = &behaviour_factories.back();
+    engine->onNextTick(timer_owner, [this, factory]()
+    {
+        runBehaviour(*factory);
+    });
+}
+
+void Object::runBehaviour(const function<Behaviour(Object *)> &factory)
+{
+    behaviours.remove_if([](Behaviour &behaviour) { return behaviour.done(); });
+    behaviours.push_back(factory(this));
+    behaviours.back().start(this);
 }
 
 shared_ptr<Object> Object::getParent()
 {
-    return parent_view.lock();
+    return parent_handle.lock();
 }
 
-string Object::getDesiredName()
+const string &Object::getDesiredName()
 {
-    return desiredName;
+    return desiredName.str();
 }
 
-string Object::getName()
+const string &Object::getName()
 {
-    return name;
+    return name.str();
 }
 
 void Object::attachHandler(shared_ptr<HandlerI> handle)
 {
-    handle->setOwner(shared_from_this());
+    handle->setOwner(this);
     handlers.push_back(handle);
-    if(engine_view.lock())
-        getEngine()->disp->registerEventHandler(handle);
+    Engine *engine = engine_ptr;
+    if (engine && active)
+        engine->registerHandler(handle);
+}
+
+shared_ptr<Object> Object::cloneSelf() const
+{
+    return make_shared<Object>(*this);
+}
+
+shared_ptr<Object> Object::clone() const
+{
+    auto copy = cloneSelf();
+    if (typeid(*copy) != typeid(*this))
+        throw std::runtime_error(string("Cannot clone ") + typeid(*this).name() + ", it does not override cloneSelf()");
+    for (auto &child : children)
+        copy->addChild(child->clone()); // in order, so that the children are given the same names
+    return copy;
+}
+
+void Object::resetTo(Object &prototype)
+{
+    restoreSelf(prototype);
+    size_t count = std::min(children.size(), prototype.children.size());
+    for (size_t i = 0; i < count; i++)
+        children.at(i)->resetTo(*prototype.children.at(i));
+}
+
+void Object::setActive(bool active)
+{
+    this->active = active;
+    Engine *engine = engine_ptr;
+    if (engine)
+        engine->refreshActive(this);
+    for (auto &child : children)
+        child->setActive(active);
 }
 
 void Object::dettachHandler(shared_ptr<HandlerI> handle)
 {
     handlers.remove(handle);
     handle->clearOwner();
+    Engine *engine = engine_ptr;
+    if (engine)
+        engine->unregisterHandler(handle);
+}
+
+void Object::detachChild(shared_ptr<Object> child)
+{
+    children.erase(child.get());
+    children_map.erase(child->name);
+    if (child->name_suffix > 0)
+    {
+        auto &free = name_suffixes.at(child->suffix_base).free;
+        free.push_back(child->name_suffix);
+        std::push_heap(free.begin(), free.end(), std::greater<int>());
+        child->suffix_base = Atom();
+        child->name_suffix = 0;
+    }
+    structure_stamp = next_structure_stamp++;
+    child->parent_handle = ObjectHandle();
+    child->name = Atom();
+    child->parentChanged(true);
 }
 
 void Object::addChild(shared_ptr<Object> child)
 {
-    if (std::find(children.begin(), children.end(), child) != children.end())
+    if (children.contains(child.get()))
         return; // child already exists
+    Object *old_parent = child->parent_handle.get();
+    if (old_parent)
+        old_parent->detachChild(child); // reparent, registration is sorted out bellow
+    Engine *engine = engine_ptr;
+    Engine *old_engine = child->engine_ptr;
+    if (old_engine && old_engine != engine)
+        old_engine->unregisterObj(child);
     // give child name and insert
-    string name = child->getDesiredName();
-    string unique_name = name;
-    for(int i = 1; children_map.find(unique_name) != children_map.end(); i++)
+    Atom name = child->desiredName;
+    Atom unique_name = name;
+    int suffix = 0;
+    if (children_map.count(unique_name))
     {
-        // if the name is already unique, we dont enter this loop and it remains as it was originally
-        unique_name = name + "_" + std::to_string(i);
+        NameSuffixes &taken = name_suffixes[name];
+        while (true)
+        {
+            if (!taken.free.empty())
+            {
+                std::pop_heap(taken.free.begin(), taken.free.end(), std::greater<int>());
+                suffix = taken.free.back();
+                taken.free.pop_back();
+            }
+            else
+            {
+                thread_local string text; // keeps its capacity
+                char digits[16];
+                suffix = taken.names.size() + 1;
+                auto end = std::to_chars(digits, digits + sizeof(digits), suffix).ptr;
+                text.assign(name.str()).append(1, '_').append(digits, end);
+                taken.names.emplace_back(text);
+            }
+            unique_name = taken.names[suffix - 1];
+            auto holder = children_map.find(unique_name);
+            if (holder == children_map.end())
+                break;
+            // a child named so outright holds the suffix as well, until it is removed
+            holder->second->suffix_base = name;
+            holder->second->name_suffix = suffix;
+        }
     }
     children_map.emplace(unique_name, child);
     children.push_back(child);
+    structure_stamp = next_structure_stamp++;
     // insert end
     child->name = unique_name;
-    child->parent_view = weak_ptr<Object>(shared_from_this());
-    auto engine = getEngine();
+    child->suffix_base = suffix > 0 ? name : Atom();
+    child->name_suffix = suffix;
+    child->parent_handle = self_handle;
+    child->parentChanged(true);
     if (engine != nullptr)
         engine->registerObj(child);
 }
 
 shared_ptr<Object> Object::getChild(int index)
 {
-    if (children.size() <= index)
+    if (index < 0)
         throw std::out_of_range("Index out of range");
-    auto iter = children.begin();
-    std::advance(iter, index);
-    return *iter;
+    return children.at(index);
 }
 #if 0
 shared_ptr<Object> Object::getChild(vector<int> indices)
@@ -104,56 +313,46 @@ shared_ptr<Object> Object::getChild(vector<int> indices)
         throw std::invalid_argument("Indices list is empty");
     int index = indices.front(); // front of the list
 
-    if (children.size() <= index)
-        throw std::out_of_range("Index out of range");
-    auto iter = children.begin();
-    std::advance(iter, index);
+    auto child = getChild(index);
 
     if (indices.size() == 1)
-        return *iter;
+        return child;
 
     std::vector<int> remainder(indices.begin() + 1, indices.end());
-    return (*iter)->getChild(remainder);
+    return child->getChild(remainder);
 }
 #endif
-shared_ptr<Object> Object::getChild(string path)
+shared_ptr<Object> Object::getChild(const NodePath &path)
 {
-    int delim = path.find('/');
-    string current = path.substr(0, delim);
-    auto it = children_map.find(current);
+    return path.resolve(this);
+}
 
-    if (it == children_map.end())
-        throw std::out_of_range("Child " + current + " not found");
-    
-    if (delim == string::npos)
-        return it->second;
-    
-    return it->second->getChild(path.substr(delim + 1));
+shared_ptr<Object> Object::getChild(std::string_view path)
+{
+    return NodePath::find(this, path);
 }
 
 shared_ptr<Object> Object::removeChild(int index)
-    {
-        if (children.size() <= index)
-            throw std::out_of_range("Index out of range");
-        auto iter = children.begin();
-        std::advance(iter, index);
-        shared_ptr<Object> child = *iter;
-        children.erase(iter);
-        children_map.erase(child->name);
-        child->parent_view.reset();
-        child->engine_view.reset();
-        child->name = "";
-        return child;
-    }
+{
+    shared_ptr<Object> child = getChild(index);
+    detachChild(child);
+    Engine *engine = engine_ptr;
+    if (engine)
+        engine->unregisterObj(child);
+    return child;
+}
 
-shared_ptr<Object> Object::removeChild(string name)
+shared_ptr<Object> Object::removeChild(const string &name)
 {
-    shared_ptr<Object> child = children_map.at(name);
-    children.erase(std::find(children.begin(), children.end(), child));
-    children_map.erase(name);
-    child->parent_view.reset();
-    child->getEngine()->unregisterObj(child);
-    child->name = "";
+    auto atom = Atom::find(name); // a name never interned is no child's
+    auto it = atom ? children_map.find(*atom) : children_map.end();
+    if (it == children_map.end())
+        throw std::out_of_range("Child " + name + " not found");
+    shared_ptr<Object> child = it->second;
+    detachChild(child);
+    Engine *engine = engine_ptr;
+    if (engine)
+        engine->unregisterObj(child);
     return child;
 }
 
@@ -165,63 +364,168 @@ void Object::attachInitBehaviour(function<void(Object *)> behavior)
 void Object::attachLoopBehaviour(function<void(Object *, double)> behavior)
 {
     this->loop_behavior = behavior;
+    Engine *engine = engine_ptr;
+    if (engine)
+        engine->refreshLoop(this);
 }
 
-const Vect2f Object2D::getPosition()
+void Object2D::parentChanged(bool reparented)
+{
+    if (reparented)
+    {
+        parent2d = parent_handle.as<Object2D>();
+        if (transform_system != nullptr)
+            transform_system->reparent(this);
+    }
+    markDirty();
+}
+
+void Object2D::markDirty()
 {
-    auto parent = dynamic_pointer_cast<Object2D>(parent_view.lock());
-    if (parent.get() == nullptr)
-        return offset;
+    if (transform_dirty)
+        return; // so are the descendants
+    transform_dirty = true;
+    for (auto &child : children)
+        child->parentChanged(false);
+}
+
+void Object2D::updateTransform()
+{
+    if (parent2d == nullptr)
+    {
+        world_position = offset;
+        world_rotation = rotation;
+        world_scale = scale;
+    }
     else
     {
-        Vect2f parent_orientation = parent->getOrientation();
-        return parent->getPosition() +
+        if (parent2d->transform_dirty)
+            parent2d->updateTransform();
+        Vect2f parent_orientation = parent2d->world_rotation;
+        world_position = parent2d->world_position +
             Vect2f(
                 offset.x * parent_orientation.x - offset.y * parent_orientation.y,
                 offset.x * parent_orientation.y + offset.y * parent_orientation.x); // standard rotation matrix
+        world_rotation = Vect2f(
+            rotation.x * parent_orientation.x - rotation.y * parent_orientation.y,
+            rotation.x * parent_orientation.y + rotation.y * parent_orientation.x);
+        world_scale = parent2d->world_scale * scale;
     }
+    transform_dirty = false;
 }
 
-const Vect2f Object2D::getSize()
+const Vect2f Object2D::getPosition()
 {
-    auto parent = dynamic_pointer_cast<Object2D>(parent_view.lock());
-    if (parent.get() == nullptr)
-        return base_size * scale;
-    else
-        return base_size * (scale * parent->scale);
+    if (transform_dirty)
+        updateTransform();
+    return world_position;
 }
 
-const Vect2f Object2D::getOrientation()
+void Object2D::setPosition(Vect2f pos)
 {
-    auto parent = dynamic_pointer_cast<Object2D>(parent_view.lock());
-    if (parent.get() == nullptr)
-        return rotation;
-    else
+    Vect2f delta = pos - getPosition();
+    if (parent2d != nullptr)
     {
-        Vect2f parent_orientation = parent->getOrientation();
-        return Vect2f(
-                rotation.x * parent_orientation.x - rotation.y * parent_orientation.y,
-                rotation.x * parent_orientation.y + rotation.y * parent_orientation.x); // standard rotation matrix
+        // into the parent's frame, by the inverse rotation
+        Vect2f parent_orientation = parent2d->getOrientation();
+        delta = Vect2f(
+            delta.x * parent_orientation.x + delta.y * parent_orientation.y,
+            delta.y * parent_orientation.x - delta.x * parent_orientation.y);
     }
+    setOffset(offset + delta);
+}
+
+void Object2D::setOffset(Vect2f offset)
+{
+    this->offset = offset;
+    transformChanged();
+}
+
+void Object2D::setScale(float scale)
+{
+    this->scale = scale;
+    transformChanged();
+}
+
+void Object2D::setRotation(Vect2f rotation)
+{
+    this->rotation = rotation;
+    transformChanged();
+}
+
+void Object2D::transformChanged()
+{
+    if (transform_system != nullptr)
+        transform_system->setLocal(transform_slot, offset, rotation, scale);
+    markDirty();
+}
+
+const Vect2f Object2D::getSize()
+{
+    if (transform_dirty)
+        updateTransform();
+    return base_size * world_scale;
 }
 
-Object2D::Object2D(string desiredName) : Object(desiredName)
+const Vect2f Object2D::getOrientation()
+{
+    if (transform_dirty)
+        updateTransform();
+    return world_rotation;
+}
+
+Object2D::Object2D(Atom desiredName) : Object(desiredName)
 {}
 
-Object2D::Object2D(Vect2f offset, Vect2f base_size, string desiredName) : Object(desiredName)
+Object2D::Object2D(Vect2f offset, Vect2f base_size, Atom desiredName) : Object(desiredName)
 {
     this->offset = offset;
     this->base_size = base_size;
     this->scale = 1;
 }
 
+Object2D::Object2D(const Object2D &other)
+    : Object(other), offset(other.offset), scale(other.scale), rotation(other.rotation), base_size(other.base_size)
+{}
+
+shared_ptr<Object> Object2D::cloneSelf() const
+{
+    return make_shared<Object2D>(*this);
+}
+
+void Object2D::restoreSelf(Object &prototype)
+{
+    auto source = dynamic_cast<Object2D *>(&prototype);
+    if (source == nullptr)
+        return;
+    offset = source->offset;
+    scale = source->scale;
+    rotation = source->rotation;
+    base_size = source->base_size;
+    transformChanged();
+}
+
 GraphicObject::GraphicObject()
 {}
 
-GraphicObject::GraphicObject(Vect2f offset, Vect2f base_size, string desiredName)
+GraphicObject::GraphicObject(Vect2f offset, Vect2f base_size, Atom desiredName)
     : Object2D(offset, base_size, desiredName)
 {}
 
+GraphicObject::GraphicObject(const GraphicObject &other) : Object2D(other), color(other.color), z(other.z)
+{}
+
+void GraphicObject::restoreSelf(Object &prototype)
+{
+    Object2D::restoreSelf(prototype);
+    auto source = dynamic_cast<GraphicObject *>(&prototype);
+    if (source == nullptr)
+        return;
+    color = source->color;
+    if (z != source->z)
+        setDrawHeight(source->z);
+}
+
 void GraphicObject::setDrawHeight(int z)
 {
     if (gsys_view == nullptr)
@@ -256,63 +560,140 @@ void GraphicObject::setDrawColor(SDL_Renderer *render, Color c)
     }
 }
 
-Texture::Texture(string desiredName) : Object(desiredName)
-{}
+Vect2f GraphicObject::getDrawPosition()
+{
+    if (gsys_view == nullptr)
+        return getPosition();
+    Vect2f current = gsys_view->transforms->position(this);
+    if (!has_previous)
+        return current;
+    return previous_position + (current - previous_position) * gsys_view->alpha;
+}
+
+TextureAtlas::~TextureAtlas()
+{
+    if (texture != nullptr)
+        SDL_DestroyTexture(texture);
+}
+
+Texture::Texture(Atom desiredName) : Object(desiredName)
+{
+    atlas = make_shared<TextureAtlas>();
+}
+
+Texture::Texture(shared_ptr<TextureAtlas> atlas, Atom desiredName) : Object(desiredName)
+{
+    this->atlas = atlas;
+}
 
 void Texture::setTexture(SDL_Renderer *render, string filepath)
 {
-    texture = IMG_LoadTexture(render, filepath.c_str());
-    if (texture == NULL)
-        throw std::runtime_error(string() + "Failed to load texture: " + IMG_GetError());
-    SDL_QueryTexture(texture, NULL, NULL, &size.x, &size.y);
+    // a fresh atlas, others may still share the old one
+    auto loaded = make_shared<TextureAtlas>();
+    if (render == nullptr)
+    {
+        // headless, only the dimensions are needed to build sprites
+        SDL_Surface *surface = IMG_Load(filepath.c_str());
+        if (surface == NULL)
+            throw std::runtime_error(string() + "Failed to load texture: " + IMG_GetError());
+        loaded->size = {surface->w, surface->h};
+        SDL_FreeSurface(surface);
+    }
+    else
+    {
+        loaded->texture = IMG_LoadTexture(render, filepath.c_str());
+        if (loaded->texture == NULL)
+            throw std::runtime_error(string() + "Failed to load texture: " + IMG_GetError());
+        SDL_QueryTexture(loaded->texture, NULL, NULL, &loaded->size.x, &loaded->size.y);
+    }
+    atlas = loaded;
+}
+
+shared_ptr<TextureAtlas> Texture::getAtlas()
+{
+    return atlas;
 }
 
 SDL_Texture *Texture::getTexture()
 {
-    return texture;
+    return atlas->texture;
 }
 
 void Texture::defineSprite(Vect4i src_region, string name)
 {
-    Sprite sprite(static_pointer_cast<Texture>(shared_from_this()), src_region, Vect2f(0, 0), Vect2f(src_region.z(), src_region.w()));
-    sprites.emplace(name, sprite);
+    atlas->sprites[name] = {src_region.x(), src_region.y(), src_region.z(), src_region.w()};
 }
 
 shared_ptr<Sprite> Texture::buildSprite(string name)
 {
-    // Sprite &sprite = sprites.at(name);
-    return make_shared<Sprite>(sprites.at(name)); // throws an exception without explaining what the issue is
+    auto region = atlas->sprites.find(name);
+    if (region == atlas->sprites.end())
+        throw std::out_of_range("No sprite named " + name);
+    const SDL_Rect &rect = region->second;
+    return make_shared<Sprite>(atlas, rect, Vect2f(0, 0), Vect2f(rect.w, rect.h));
 }
 
-Texture::~Texture()
+shared_ptr<Object> Texture::cloneSelf() const
 {
-    SDL_DestroyTexture(texture);
+    return make_shared<Texture>(*this);
 }
 
-Sprite::Sprite(shared_ptr<Texture> texture, Vect4i src_region, Vect2f offset, Vect2f size, string desiredName) 
+Sprite::Sprite(shared_ptr<Texture> texture, Vect4i src_region, Vect2f offset, Vect2f size, Atom desiredName) 
+    : Sprite(texture->getAtlas(), SDL_Rect{src_region.x(), src_region.y(), src_region.z(), src_region.w()}, offset, size, desiredName)
+{}
+
+Sprite::Sprite(shared_ptr<TextureAtlas> atlas, SDL_Rect src_region, Vect2f offset, Vect2f size, Atom desiredName)
     : GraphicObject(offset, size, desiredName)
 {
-    this->texture = texture;
-    this->src_region = {src_region.x(), src_region.y(), src_region.z(), src_region.w()};
+    this->atlas = atlas;
+    this->src_region = src_region;
+}
+
+shared_ptr<Object> Sprite::cloneSelf() const
+{
+    return make_shared<Sprite>(*this);
+}
+
+void Sprite::restoreSelf(Object &prototype)
+{
+    GraphicObject::restoreSelf(prototype);
+    auto source = dynamic_cast<Sprite *>(&prototype);
+    if (source == nullptr)
+        return;
+    atlas = source->atlas;
+    src_region = source->src_region;
 }
 
 void Sprite::scaleX(int x)
 {
-    scale = x / base_size.x;
+    setScale(x / base_size.x);
 }
 
 void Sprite::scaleY(int y)
 {
-    scale = y / base_size.y;
+    setScale(y / base_size.y);
 }
 
-void Sprite::draw()
+DrawCommand Sprite::makeCommand()
 {
-    auto pos = gsys_view->screenTransform({(int)getPosition().x, (int)getPosition().y});
+    Vect2f draw_pos = getDrawPosition();
+    Vect2f size = base_size * gsys_view->transforms->scale(this);
+    auto pos = gsys_view->screenTransform({(int)draw_pos.x, (int)draw_pos.y});
     SDL_Rect dest = {
-        pos.x - (int)getSize().x / 2, pos.y - (int)getSize().y / 2,
-        (int)(getSize().x * gsys_view->camera_zoom), (int)(getSize().y * gsys_view->camera_zoom)};
-    if (SDL_RenderCopyEx(render_view, texture->getTexture(), &src_region, &dest, 0, NULL, SDL_FLIP_NONE))
+        pos.x - (int)size.x / 2, pos.y - (int)size.y / 2,
+        (int)(size.x * gsys_view->camera_zoom), (int)(size.y * gsys_view->camera_zoom)};
+    return {atlas, src_region, dest};
+}
+
+void Sprite::record(vector<DrawCommand> &list)
+{
+    list.push_back(makeCommand());
+}
+
+void Sprite::draw()
+{
+    DrawCommand command = makeCommand();
+    if (SDL_RenderCopyEx(render_view, atlas->texture, &command.src, &command.dest, 0, NULL, SDL_FLIP_NONE))
         // TODO: copy ex supports hardware acceld rotation in the last 3 params
         // which wwe currently do not support
         std::cout << SDL_GetError() << '\n';
@@ -320,5 +701,13 @@ void Sprite::draw()
 
 void EngineController::init()
 {
-    timeout.start_timer();
+    double limit = getEngine()->config.time_limit;
+    if (limit <= 0)
+        return;
+    after(limit, [this]()
+    {
+        auto engine = getEngine();
+        if (engine->free_running)
+            engine->stop();
+    });
 }
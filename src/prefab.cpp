@@ -0,0 +1,42 @@
+/**
+ * @file prefab.cpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <prefab.hpp>
+#include <objects.hpp>
+
+Prefab::Prefab(shared_ptr<Object> prototype, size_t capacity) : prototype(prototype), capacity(capacity)
+{
+}
+
+shared_ptr<Object> Prefab::instantiate()
+{
+    if (pool.empty())
+        return prototype->clone();
+    auto instance = std::move(pool.back());
+    pool.pop_back();
+    instance->resetTo(*prototype);
+    instance->setActive(true);
+    return instance;
+}
+
+void Prefab::release(shared_ptr<Object> instance)
+{
+    if (!instance->isActive())
+        return; // released already
+    if (pool.size() < capacity)
+    {
+        instance->setActive(false);
+        pool.push_back(std::move(instance));
+        return;
+    }
+    auto parent = instance->getParent();
+    if (parent)
+        parent->removeChild(instance->getName());
+}
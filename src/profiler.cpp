@@ -0,0 +1,108 @@
+/**
+ * @file profiler.cpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <profiler.hpp>
+
+#include <fstream>
+
+#include <logger.hpp>
+
+Profiler::Profiler()
+{
+    start_time = std::chrono::steady_clock::now();
+    capturing = false;
+}
+
+Profiler &Profiler::instance()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::ThreadBuffer &Profiler::localBuffer()
+{
+    thread_local shared_ptr<ThreadBuffer> buffer;
+    if (!buffer)
+    {
+        buffer = make_shared<ThreadBuffer>();
+        std::lock_guard<mutex> lock(buffers_m);
+        buffer->thread_id = buffers.size() + 1;
+        buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+void Profiler::capture(unsigned long first_frame, unsigned long last_frame, string path)
+{
+    std::lock_guard<mutex> lock(buffers_m);
+    this->first_frame = first_frame > frame ? first_frame : frame.load();
+    this->last_frame = last_frame;
+    this->path = path;
+    capturing = frame >= this->first_frame && frame <= last_frame;
+}
+
+void Profiler::frameMark()
+{
+    uint64_t end = now();
+    if (capturing)
+        record("Frame", frame_start, end);
+    frame_start = end;
+    frame++;
+    if (path.empty())
+        return;
+    if (frame > last_frame)
+    {
+        capturing = false;
+        writeTrace();
+    }
+    else if (frame >= first_frame)
+        capturing = true;
+}
+
+void Profiler::record(const char *name, uint64_t start, uint64_t end)
+{
+    ThreadBuffer &buffer = localBuffer();
+    std::lock_guard<mutex> lock(buffer.m);
+    buffer.events.push_back({name, start, end, frame});
+}
+
+void Profiler::writeTrace()
+{
+    std::lock_guard<mutex> lock(buffers_m);
+    std::ofstream file(path);
+    if (!file)
+        LOG_ERROR("Failed to open profiler trace file");
+    else
+    {
+        file << "{\"traceEvents\":[\n";
+        bool first = true;
+        char line[256];
+        for (auto &buffer : buffers)
+        {
+            std::lock_guard<mutex> buffer_lock(buffer->m);
+            for (auto &event : buffer->events)
+            {
+                // chrome's trace format wants microseconds
+                std::snprintf(line, sizeof(line),
+                    "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%lu}}",
+                    first ? "" : ",\n", event.name, buffer->thread_id, event.start / 1e3, (event.end - event.start) / 1e3, event.frame);
+                file << line;
+                first = false;
+            }
+        }
+        file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    }
+    for (auto &buffer : buffers)
+    {
+        std::lock_guard<mutex> buffer_lock(buffer->m);
+        buffer->events.clear();
+    }
+    path.clear();
+}
@@ -0,0 +1,252 @@
+/**
+ * @file replay.cpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <replay.hpp>
+
+#include <cstring>
+#include <iterator>
+
+using namespace replay_format;
+
+ReplayWriter::ReplayWriter(string path, uint32_t seed, double tick_rate, unsigned long start_tick)
+    : file(path, std::ios::binary)
+{
+    if (!file)
+        throw std::runtime_error("Failed to create replay file " + path);
+    this->start_tick = start_tick;
+    file.write(magic, sizeof(magic));
+    writeByte(version & 0xff);
+    writeByte(version >> 8);
+    for (int i = 0; i < 4; i++)
+        writeByte((seed >> (i * 8)) & 0xff);
+    uint64_t rate_bits;
+    std::memcpy(&rate_bits, &tick_rate, sizeof(rate_bits));
+    for (int i = 0; i < 8; i++)
+        writeByte((rate_bits >> (i * 8)) & 0xff);
+}
+
+ReplayWriter::~ReplayWriter()
+{
+    if (!finished)
+        finish(start_tick + last_tick);
+}
+
+void ReplayWriter::writeByte(uint8_t value)
+{
+    file.put((char)value);
+}
+
+void ReplayWriter::writeVarint(uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        writeByte((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    writeByte(value);
+}
+
+void ReplayWriter::writeSigned(int64_t value)
+{
+    writeVarint(((uint64_t)value << 1) ^ (uint64_t)(value >> 63)); // zigzag, small negatives stay short
+}
+
+void ReplayWriter::writeRecord(unsigned long tick, Kind kind)
+{
+    unsigned long relative = tick - start_tick;
+    writeVarint(relative - last_tick);
+    writeByte(kind);
+    last_tick = relative;
+}
+
+void ReplayWriter::write(unsigned long tick, const SDL_Event &e)
+{
+    if (finished)
+        return;
+    if (e.type == SDL_KEYDOWN || e.type == SDL_KEYUP)
+    {
+        writeRecord(tick, KEY);
+        writeByte(e.type == SDL_KEYDOWN);
+        writeByte(e.key.repeat);
+        writeVarint(e.key.keysym.scancode);
+        writeSigned(e.key.keysym.sym);
+        writeByte(e.key.keysym.mod & 0xff);
+        writeByte(e.key.keysym.mod >> 8);
+    }
+    else if (e.type == SDL_MOUSEBUTTONDOWN || e.type == SDL_MOUSEBUTTONUP)
+    {
+        writeRecord(tick, MOUSE);
+        writeByte(e.type == SDL_MOUSEBUTTONDOWN);
+        writeByte(e.button.button);
+        writeByte(e.button.clicks);
+        writeSigned(e.button.x);
+        writeSigned(e.button.y);
+    }
+    else
+        return;
+    file.flush(); // keep the recording usable if the process dies
+}
+
+void ReplayWriter::paused(unsigned long tick)
+{
+    if (finished)
+        return;
+    writeRecord(tick, PAUSED);
+}
+
+void ReplayWriter::finish(unsigned long tick)
+{
+    if (finished)
+        return;
+    writeRecord(tick, END);
+    file.close();
+    finished = true;
+}
+
+namespace
+{
+    struct Cursor
+    {
+        const vector<uint8_t> &data;
+        size_t position = 0;
+
+        bool atEnd()
+        {
+            return position >= data.size();
+        }
+
+        uint8_t byte()
+        {
+            if (atEnd())
+                throw std::out_of_range("Replay cut short");
+            return data[position++];
+        }
+
+        uint64_t varint()
+        {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7)
+            {
+                uint8_t b = byte();
+                value |= (uint64_t)(b & 0x7f) << shift;
+                if (!(b & 0x80))
+                    return value;
+            }
+            throw std::runtime_error("Malformed varint in replay");
+        }
+
+        int64_t zigzag()
+        {
+            uint64_t value = varint();
+            return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+        }
+    };
+}
+
+ReplayReader::ReplayReader(string path, unsigned long start_tick)
+{
+    this->start_tick = start_tick;
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("Failed to open replay file " + path);
+    vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    Cursor in{data};
+    const size_t header_size = sizeof(magic) + 2 + 4 + 8;
+    if (data.size() < header_size || std::memcmp(data.data(), magic, sizeof(magic)) != 0)
+        throw std::runtime_error("Not a replay file: " + path);
+    in.position = sizeof(magic);
+    uint16_t file_version = in.byte();
+    file_version |= in.byte() << 8;
+    if (file_version < 1 || file_version > version)
+        throw std::runtime_error("Unsupported replay version in " + path);
+    seed = 0;
+    for (int i = 0; i < 4; i++)
+        seed |= (uint32_t)in.byte() << (i * 8);
+    uint64_t rate_bits = 0;
+    for (int i = 0; i < 8; i++)
+        rate_bits |= (uint64_t)in.byte() << (i * 8);
+    std::memcpy(&tick_rate, &rate_bits, sizeof(tick_rate));
+
+    unsigned long tick = 0;
+    bool ended = false;
+    try
+    {
+        while (!in.atEnd())
+        {
+            tick += in.varint();
+            Kind kind = (Kind)in.byte();
+            SDL_Event e;
+            std::memset(&e, 0, sizeof(e));
+            if (kind == END)
+            {
+                length = tick;
+                ended = true;
+                break;
+            }
+            else if (kind == PAUSED)
+            {
+                paused_ticks.push_back(tick);
+                continue;
+            }
+            else if (kind == KEY)
+            {
+                e.type = in.byte() ? SDL_KEYDOWN : SDL_KEYUP;
+                e.key.state = e.type == SDL_KEYDOWN ? SDL_PRESSED : SDL_RELEASED;
+                e.key.repeat = in.byte();
+                e.key.keysym.scancode = (SDL_Scancode)in.varint();
+                e.key.keysym.sym = (SDL_Keycode)in.zigzag();
+                e.key.keysym.mod = in.byte();
+                e.key.keysym.mod |= in.byte() << 8;
+            }
+            else if (kind == MOUSE)
+            {
+                e.type = in.byte() ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP;
+                e.button.state = e.type == SDL_MOUSEBUTTONDOWN ? SDL_PRESSED : SDL_RELEASED;
+                e.button.button = in.byte();
+                e.button.clicks = in.byte();
+                e.button.x = in.zigzag();
+                e.button.y = in.zigzag();
+            }
+            else
+                throw std::runtime_error("Unknown record in replay " + path);
+            events.push_back({tick, e});
+        }
+    }
+    catch (std::out_of_range &)
+    {
+        // the last record was cut off, keep what was complete
+    }
+    if (!ended)
+    {
+        length = events.empty() ? 0 : events.back().first + 1;
+        if (!paused_ticks.empty() && paused_ticks.back() + 1 > length)
+            length = paused_ticks.back() + 1;
+    }
+}
+
+bool ReplayReader::next(unsigned long tick, SDL_Event &e)
+{
+    unsigned long relative = tick - start_tick;
+    // events of ticks already gone by would be out of order, they are dropped
+    while (next_event < events.size() && events[next_event].first < relative)
+        next_event++;
+    if (next_event >= events.size() || events[next_event].first != relative)
+        return false;
+    e = events[next_event++].second;
+    return true;
+}
+
+bool ReplayReader::paused(unsigned long tick)
+{
+    unsigned long relative = tick - start_tick;
+    while (next_paused < paused_ticks.size() && paused_ticks[next_paused] < relative)
+        next_paused++;
+    return next_paused < paused_ticks.size() && paused_ticks[next_paused] == relative;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file stats.cpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <stats.hpp>
+
+int RollingHistogram::bucketOf(double ms)
+{
+    for (int i = 0; i < FrameHistogram::buckets - 1; i++)
+        if (ms < FrameHistogram::bound(i))
+            return i;
+    return FrameHistogram::buckets - 1;
+}
+
+void RollingHistogram::add(double ms)
+{
+    if (count == window)
+    {
+        sum -= samples[next];
+        counts[bucketOf(samples[next])]--;
+    }
+    else
+        count++;
+    samples[next] = ms;
+    sum += samples[next]; // as stored, so that dropping it later subtracts the same value
+    counts[bucketOf(samples[next])]++;
+    next = (next + 1) % window;
+}
+
+FrameHistogram RollingHistogram::summary() const
+{
+    FrameHistogram summary;
+    summary.samples = count;
+    if (count == 0)
+        return summary;
+    summary.mean = sum / count;
+    summary.last = samples[(next + window - 1) % window];
+    for (size_t i = 0; i < count; i++)
+        summary.max = std::max(summary.max, (double)samples[i]);
+    std::copy(counts, counts + FrameHistogram::buckets, summary.counts);
+    return summary;
+}
+
+namespace
+{
+    void appendHistogram(string &json, const char *name, const FrameHistogram &histogram)
+    {
+        char buffer[160];
+        std::snprintf(buffer, sizeof(buffer), ",\"%s\":{\"samples\":%lu,\"mean\":%.4f,\"max\":%.4f,\"last\":%.4f,\"bounds\":[",
+            name, histogram.samples, histogram.mean, histogram.max, histogram.last);
+        json += buffer;
+        for (int i = 0; i < FrameHistogram::buckets - 1; i++) // the last bucket has no bound
+        {
+            std::snprintf(buffer, sizeof(buffer), "%s%g", i ? "," : "", FrameHistogram::bound(i));
+            json += buffer;
+        }
+        json += "],\"counts\":[";
+        for (int i = 0; i < FrameHistogram::buckets; i++)
+        {
+            std::snprintf(buffer, sizeof(buffer), "%s%u", i ? "," : "", histogram.counts[i]);
+            json += buffer;
+        }
+        json += "]}";
+    }
+}
+
+string EngineStats::toJson() const
+{
+    char buffer[320];
+    std::snprintf(buffer, sizeof(buffer),
+        "{\"ticks\":%lu,\"sim_time\":%.6f,\"objects\":%zu,\"looping_objects\":%zu,\"handlers\":%zu,"
+        "\"graphic_objects\":%zu,\"physics_bodies\":%zu,\"pending_timers\":%zu",
+        ticks, sim_time, objects, looping_objects, handlers, graphic_objects, physics_bodies, pending_timers);
+    string json = buffer;
+    appendHistogram(json, "input", input);
+    appendHistogram(json, "simulation", simulation);
+    appendHistogram(json, "physics", physics);
+    appendHistogram(json, "render", render);
+    appendHistogram(json, "frame", frame);
+    json += "}";
+    return json;
+}
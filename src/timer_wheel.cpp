@@ -0,0 +1,212 @@
+/**
+ * @file timer_wheel.cpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <timer_wheel.hpp>
+#include <profiler.hpp>
+
+TimerWheel::TimerWheel(double resolution)
+{
+    this->resolution = resolution;
+    heads.assign(levels * slots, -1);
+}
+
+TimerId TimerWheel::schedule(double delay, function<void()> callback, weak_ptr<void> owner)
+{
+    return add(delay, 0, std::move(callback), std::move(owner));
+}
+
+TimerId TimerWheel::repeat(double period, function<void()> callback, weak_ptr<void> owner)
+{
+    return add(period, period, std::move(callback), std::move(owner));
+}
+
+TimerId TimerWheel::add(double delay, double period, function<void()> callback, weak_ptr<void> owner)
+{
+    int32_t index;
+    if (free_timers.empty())
+    {
+        index = timers.size();
+        timers.emplace_back();
+    }
+    else
+    {
+        index = free_timers.back();
+        free_timers.pop_back();
+    }
+    Timer &timer = timers[index];
+    // an empty weak_ptr is not ordered before or after another empty one
+    timer.owned = owner.owner_before(weak_ptr<void>()) || weak_ptr<void>().owner_before(owner);
+    timer.owner = std::move(owner);
+    timer.callback = std::move(callback);
+    uint64_t delay_steps = delay > 0 ? (uint64_t)std::ceil(delay / resolution) : 0;
+    timer.expires = now_step + (delay_steps > 0 ? delay_steps : 1); // never in the current step
+    timer.period = period > 0 ? (uint64_t)std::max(1.0, std::ceil(period / resolution)) : 0;
+    timer.active = true;
+    active_count++;
+    insert(index);
+    return ((TimerId)timer.generation << 32) | (uint32_t)index;
+}
+
+void TimerWheel::insert(int32_t index)
+{
+    Timer &timer = timers[index];
+    uint64_t delta = timer.expires - now_step;
+    const uint64_t max_delta = ((uint64_t)1 << (levels * bits)) - 1;
+    if (delta > max_delta)
+    {
+        delta = max_delta;
+        timer.expires = now_step + delta;
+    }
+    int level = 0;
+    while (level < levels - 1 && delta >= ((uint64_t)1 << ((level + 1) * bits)))
+        level++;
+    int32_t slot = level * slots + ((timer.expires >> (level * bits)) & mask);
+    timer.slot = slot;
+    timer.prev = -1;
+    timer.next = heads[slot];
+    if (heads[slot] >= 0)
+        timers[heads[slot]].prev = index;
+    heads[slot] = index;
+}
+
+void TimerWheel::unlink(int32_t index)
+{
+    Timer &timer = timers[index];
+    if (timer.slot < 0)
+        return;
+    if (timer.prev >= 0)
+        timers[timer.prev].next = timer.next;
+    else
+        heads[timer.slot] = timer.next;
+    if (timer.next >= 0)
+        timers[timer.next].prev = timer.prev;
+    timer.slot = timer.prev = timer.next = -1;
+}
+
+void TimerWheel::release(int32_t index)
+{
+    Timer &timer = timers[index];
+    timer.callback = nullptr;
+    timer.owner.reset();
+    timer.active = false;
+    timer.generation++;
+    if (timer.generation == 0)
+        timer.generation = 1;
+    active_count--;
+    free_timers.push_back(index);
+}
+
+bool TimerWheel::cancel(TimerId id)
+{
+    if (!isPending(id))
+        return false;
+    int32_t index = (int32_t)(id & 0xffffffff);
+    unlink(index);
+    release(index);
+    return true;
+}
+
+bool TimerWheel::isPending(TimerId id)
+{
+    uint32_t index = id & 0xffffffff;
+    uint32_t generation = id >> 32;
+    return index < timers.size() && timers[index].active && timers[index].generation == generation;
+}
+
+void TimerWheel::cascade(int level, uint32_t index)
+{
+    int32_t slot = level * slots + index;
+    int32_t current = heads[slot];
+    heads[slot] = -1;
+    while (current >= 0)
+    {
+        int32_t next = timers[current].next;
+        insert(current); // lands on a lower level, now that it is closer
+        current = next;
+    }
+}
+
+void TimerWheel::step()
+{
+    now_step++;
+    // when a level completes a turn, the next slot of the level above it is spread over the lower levels
+    for (int level = 1; level < levels; level++)
+    {
+        if (((now_step >> ((level - 1) * bits)) & mask) != 0)
+            break;
+        cascade(level, (now_step >> (level * bits)) & mask);
+    }
+
+    int32_t slot = now_step & mask;
+    if (heads[slot] < 0)
+        return;
+    // take the due timers out first, callbacks may schedule and cancel freely
+    for (int32_t current = heads[slot]; current >= 0; current = timers[current].next)
+        firing.push_back({current, timers[current].generation});
+    for (auto &entry : firing)
+        timers[entry.first].slot = -1;
+    heads[slot] = -1;
+
+    for (size_t i = 0; i < firing.size(); i++)
+    {
+        int32_t index = firing[i].first;
+        uint32_t generation = firing[i].second;
+        if (!timers[index].active || timers[index].generation != generation)
+            continue; // cancelled by an earlier callback
+        if (timers[index].owned && timers[index].owner.expired())
+        {
+            release(index);
+            continue;
+        }
+        // repeating timers are back in the wheel before their callback runs, so they can cancel themselves
+        function<void()> callback;
+        if (timers[index].period > 0)
+        {
+            callback = timers[index].callback;
+            timers[index].expires += timers[index].period;
+            insert(index);
+        }
+        else
+        {
+            callback = std::move(timers[index].callback);
+            release(index);
+        }
+        try
+        {
+            callback();
+        }
+        catch (...)
+        {
+            // the timers left in this step fire on the next one
+            for (size_t j = i + 1; j < firing.size(); j++)
+            {
+                Timer &timer = timers[firing[j].first];
+                if (timer.active && timer.generation == firing[j].second)
+                {
+                    timer.expires = now_step + 1;
+                    insert(firing[j].first);
+                }
+            }
+            firing.clear();
+            throw;
+        }
+    }
+    firing.clear();
+}
+
+void TimerWheel::advance(double seconds)
+{
+    PROFILE_ZONE("TimerWheel::advance");
+    remainder += seconds;
+    uint64_t steps = (uint64_t)(remainder / resolution);
+    remainder -= steps * resolution;
+    for (uint64_t i = 0; i < steps; i++)
+        step();
+}
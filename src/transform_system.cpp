@@ -0,0 +1,175 @@
+/**
+ * @file transform_system.cpp
+ * @author Alex (aleksandriliev05@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <transform_system.hpp>
+#include <objects.hpp>
+#include <profiler.hpp>
+
+TransformSystem::TransformSystem()
+{
+    // the identity transform of slot 0 stands in for the parent of roots, so the pass does not branch on them
+    parent = {0};
+    owners = {nullptr};
+    local_x = local_y = local_ry = world_x = world_y = world_ry = {0};
+    local_rx = local_scale = world_rx = world_scale = {1};
+}
+
+TransformSystem::~TransformSystem()
+{
+    for (Object2D *obj : owners)
+        if (obj != nullptr)
+        {
+            obj->transform_system = nullptr;
+            obj->transform_slot = -1;
+        }
+}
+
+void TransformSystem::add(Object2D *obj)
+{
+    if (obj->transform_system == this)
+        return;
+    insert(obj);
+    for (auto &child : obj->children)
+    {
+        auto child2d = dynamic_cast<Object2D *>(child.get());
+        if (child2d != nullptr && child2d->transform_system == this)
+            append(child2d);
+    }
+}
+
+void TransformSystem::insert(Object2D *obj)
+{
+    int slot = owners.size();
+    Object2D *up = obj->parent2d;
+    parent.push_back(up != nullptr && up->transform_system == this ? up->transform_slot : 0);
+    owners.push_back(obj);
+    local_x.push_back(obj->offset.x);
+    local_y.push_back(obj->offset.y);
+    local_rx.push_back(obj->rotation.x);
+    local_ry.push_back(obj->rotation.y);
+    local_scale.push_back(obj->scale);
+    // valid until the next update() without one, from the object's own cache
+    Vect2f position = obj->getPosition(), orientation = obj->getOrientation();
+    world_x.push_back(position.x);
+    world_y.push_back(position.y);
+    world_rx.push_back(orientation.x);
+    world_ry.push_back(orientation.y);
+    world_scale.push_back(obj->world_scale);
+    obj->transform_system = this;
+    obj->transform_slot = slot;
+}
+
+void TransformSystem::remove(Object2D *obj)
+{
+    if (obj->transform_system != this)
+        return;
+    int slot = obj->transform_slot;
+    parent[slot] = 0;
+    owners[slot] = nullptr;
+    free_slots++;
+    obj->transform_system = nullptr;
+    obj->transform_slot = -1;
+}
+
+void TransformSystem::reparent(Object2D *obj)
+{
+    if (obj->transform_system != this)
+        return;
+    Object2D *up = obj->parent2d;
+    int up_slot = up != nullptr && up->transform_system == this ? up->transform_slot : 0;
+    if (up_slot < obj->transform_slot)
+    {
+        parent[obj->transform_slot] = up_slot; // still after its parent
+        return;
+    }
+    append(obj);
+}
+
+void TransformSystem::append(Object2D *obj)
+{
+    remove(obj);
+    insert(obj);
+    for (auto &child : obj->children)
+    {
+        auto child2d = dynamic_cast<Object2D *>(child.get());
+        if (child2d != nullptr && child2d->transform_system == this)
+            append(child2d);
+    }
+}
+
+void TransformSystem::compact()
+{
+    vector<int> moved_to(owners.size(), 0);
+    size_t next = 1;
+    for (size_t slot = 1; slot < owners.size(); slot++)
+    {
+        if (owners[slot] == nullptr)
+            continue;
+        moved_to[slot] = next;
+        parent[next] = moved_to[parent[slot]]; // parents come first, so theirs is already known
+        owners[next] = owners[slot];
+        local_x[next] = local_x[slot];
+        local_y[next] = local_y[slot];
+        local_rx[next] = local_rx[slot];
+        local_ry[next] = local_ry[slot];
+        local_scale[next] = local_scale[slot];
+        world_x[next] = world_x[slot];
+        world_y[next] = world_y[slot];
+        world_rx[next] = world_rx[slot];
+        world_ry[next] = world_ry[slot];
+        world_scale[next] = world_scale[slot];
+        owners[next]->transform_slot = next;
+        next++;
+    }
+    for (auto array : {&local_x, &local_y, &local_rx, &local_ry, &local_scale, &world_x, &world_y, &world_rx, &world_ry, &world_scale})
+        array->resize(next);
+    parent.resize(next);
+    owners.resize(next);
+    free_slots = 0;
+}
+
+void TransformSystem::update()
+{
+    PROFILE_ZONE("TransformSystem::update");
+    if (free_slots > 64 && free_slots * 2 > owners.size())
+        compact();
+    size_t count = owners.size();
+    const int *up = parent.data();
+    const float *lx = local_x.data(), *ly = local_y.data(), *lrx = local_rx.data(), *lry = local_ry.data(), *ls = local_scale.data();
+    float *wx = world_x.data(), *wy = world_y.data(), *wrx = world_rx.data(), *wry = world_ry.data(), *ws = world_scale.data();
+    for (size_t i = 1; i < count; i++)
+    {
+        int p = up[i];
+        float prx = wrx[p], pry = wry[p];
+        // standard rotation matrix, grouped as Object2D groups it so that both agree to the bit
+        wx[i] = wx[p] + (lx[i] * prx - ly[i] * pry);
+        wy[i] = wy[p] + (lx[i] * pry + ly[i] * prx);
+        wrx[i] = lrx[i] * prx - lry[i] * pry;
+        wry[i] = lrx[i] * pry + lry[i] * prx;
+        ws[i] = ws[p] * ls[i];
+    }
+}
+
+Vect2f TransformSystem::position(Object2D *obj)
+{
+    if (obj->transform_system != this)
+        return obj->getPosition();
+    return Vect2f(world_x[obj->transform_slot], world_y[obj->transform_slot]);
+}
+
+float TransformSystem::scale(Object2D *obj)
+{
+    if (obj->transform_system != this)
+    {
+        obj->getPosition(); // brings the cache up to date
+        return obj->world_scale;
+    }
+    return world_scale[obj->transform_slot];
+}